@@ -0,0 +1,303 @@
+namespace Lab {
+    // Execution policies for the algorithms below. Parallel cuts the work into chunks and runs them
+    // on ThreadPool::Default(), however many threads it has. chunks <= 0 lets the pool pick the
+    // number of chunks from the length
+    struct SequentialExecution {};
+    struct ParallelExecution {
+        int chunks = 0;
+    };
+    inline constexpr SequentialExecution Sequential{};
+    inline constexpr ParallelExecution Parallel{};
+
+    namespace Algorithms {
+        // Below this many items per chunk a thread costs more than it saves
+        constexpr long long ParallelGrain = 1 << 14;
+
+        // Ropes find an item in O(log n), binary search probes them by index
+        template <typename Seq>
+        struct Indexed : std::false_type {};
+        template <typename T, int Chunk>
+        struct Indexed<RopeSequence<T, Chunk>> : std::true_type {};
+
+        template <typename Seq>
+        constexpr bool Contiguous = std::is_pointer<decltype(std::declval<const Seq&>().cbegin())>::value;
+
+        inline int Parts(SequentialExecution, long long) {
+            return 1;
+        }
+        inline int Parts(ParallelExecution policy, long long count) {
+            int parts = policy.chunks > 0 ? policy.chunks : ThreadPool::Default().Chunks(count, ParallelGrain);
+            return static_cast<int>(std::max(1LL, std::min<long long>(parts, count)));
+        }
+
+        // Calls f(part, begin, end) on parts equal slices of [0, count), on the pool when there are several
+        template <typename F>
+        void ForParts(long long count, int parts, F f) {
+            if (parts <= 1) {
+                if (count > 0)
+                    f(0, 0LL, count);
+                return;
+            }
+            ThreadPool::Default().ParallelFor(count, parts, f);
+        }
+
+        // Random access to the items of any sequence: contiguous storage is used in place, the others
+        // are walked once to collect pointers to their items
+        template <typename Seq>
+        class Items {
+            using T = typename Seq::value_type;
+            const T* data = nullptr;
+            DynamicArray<const T*> pointers;
+        public:
+            explicit Items(const Seq& seq) {
+                if constexpr (Contiguous<Seq>) {
+                    data = seq.cbegin();
+                } else {
+                    pointers.Reserve(seq.GetSize());
+                    for (auto it = seq.cbegin(), end = seq.cend(); it != end; ++it)
+                        pointers.Emplace(&*it);
+                }
+            }
+            const T& operator[](long long index) const {
+                if constexpr (Contiguous<Seq>)
+                    return data[index];
+                else
+                    return *pointers.cbegin()[index];
+            }
+        };
+
+        // Sorts parts slices of [first, first + count) at once, then merges neighbouring runs pairwise,
+        // the merges of one round running side by side
+        template <typename T, typename Compare>
+        void SortItems(T* first, int count, int parts, Compare& comp) {
+            if (parts <= 1) {
+                std::sort(first, first + count, comp);
+                return;
+            }
+            auto bound = [count, parts](long long part) { return (long long)count * std::min<long long>(part, parts) / parts; };
+            ForParts(parts, parts, [&](int, long long begin, long long end) {
+                for (long long part = begin; part < end; ++part)
+                    std::sort(first + bound(part), first + bound(part + 1), comp);
+            });
+            for (int width = 1; width < parts; width *= 2) {
+                int pairs = (parts + 2 * width - 1) / (2 * width);
+                ForParts(pairs, pairs, [&](int, long long begin, long long end) {
+                    for (long long pair = begin; pair < end; ++pair) {
+                        long long low = pair * 2 * width;
+                        std::inplace_merge(first + bound(low), first + bound(low + width), first + bound(low + 2 * width), comp);
+                    }
+                });
+            }
+        }
+    }
+
+    // Sort picks the strategy of the storage: introsort in place for arrays, a relinking merge sort
+    // for lists, which moves no items, and a sorted rebuild for ropes. Only the list sort is stable
+    template <typename Policy, typename T, typename Compare = std::less<T>>
+    void Sort(const Policy& policy, ArraySequence<T>& seq, Compare comp = Compare()) {
+        Algorithms::SortItems(seq.begin(), seq.GetSize(), Algorithms::Parts(policy, seq.GetSize()), comp);
+    }
+    template <typename Policy, typename T, int N, typename Compare = std::less<T>>
+    void Sort(const Policy& policy, SmallArraySequence<T, N>& seq, Compare comp = Compare()) {
+        Algorithms::SortItems(seq.begin(), seq.GetSize(), Algorithms::Parts(policy, seq.GetSize()), comp);
+    }
+    template <typename Policy, typename T, typename Allocator, typename Compare = std::less<T>>
+    void Sort(const Policy& policy, ListSequence<T, Allocator>& seq, Compare comp = Compare()) {
+        LinkedList<T, Allocator>& list = *seq.getptr();
+        int count = seq.GetSize();
+        int parts = Algorithms::Parts(policy, count);
+        if (parts <= 1) {
+            list.Sort(comp);
+            return;
+        }
+        // Pieces share the allocator, sorting and merging them only relinks nodes, so no
+        // thread allocates from the shared pool
+        std::vector<LinkedList<T, Allocator>> pieces;
+        pieces.reserve(parts);
+        pieces.push_back(std::move(list));
+        try {
+            for (int part = 1; part < parts; ++part) {
+                long long length = (long long)count * part / parts - (long long)count * (part - 1) / parts;
+                pieces.push_back(pieces.back().SplitOff(static_cast<int>(length)));
+            }
+            Algorithms::ForParts(parts, parts, [&](int, long long begin, long long end) {
+                for (long long part = begin; part < end; ++part)
+                    pieces[part].Sort(comp);
+            });
+            for (int width = 1; width < parts; width *= 2) {
+                int pairs = (parts + 2 * width - 1) / (2 * width);
+                Algorithms::ForParts(pairs, pairs, [&](int, long long begin, long long end) {
+                    for (long long pair = begin; pair < end; ++pair) {
+                        int low = static_cast<int>(pair) * 2 * width;
+                        if (low + width < parts)
+                            pieces[low].Merge(std::move(pieces[low + width]), comp);
+                    }
+                });
+            }
+        } catch (...) {
+            // A throwing comp leaves every item in the sequence, in some order, like std::sort
+            for (LinkedList<T, Allocator>& piece : pieces)
+                list.Splice(std::move(piece));
+            throw;
+        }
+        list = std::move(pieces[0]);
+    }
+    template <typename Policy, typename T, int Chunk, typename Compare = std::less<T>>
+    void Sort(const Policy& policy, RopeSequence<T, Chunk>& seq, Compare comp = Compare()) {
+        DynamicArray<T> items;
+        items.AppendRange(seq.cbegin(), seq.cend());
+        Algorithms::SortItems(items.begin(), items.GetSize(), Algorithms::Parts(policy, items.GetSize()), comp);
+        seq.Assign(items.cbegin(), items.cend());
+    }
+    template <typename Seq, typename Compare = std::less<typename Seq::value_type>>
+    auto Sort(Seq& seq, Compare comp = Compare()) -> decltype(Sort(Sequential, seq, comp)) {
+        Sort(Sequential, seq, comp);
+    }
+
+    // Index of the first item of a sorted sequence that doesn't go before value: O(log n) probes on
+    // arrays and ropes, a list can only be walked
+    template <typename Seq, typename Compare = std::less<typename Seq::value_type>>
+    int LowerBound(const Seq& seq, const typename Seq::value_type& value, Compare comp = Compare()) {
+        if constexpr (Algorithms::Contiguous<Seq>) {
+            return static_cast<int>(std::lower_bound(seq.cbegin(), seq.cend(), value, comp) - seq.cbegin());
+        } else if constexpr (Algorithms::Indexed<Seq>::value) {
+            int low = 0, high = seq.GetSize();
+            while (low < high) {
+                int middle = low + (high - low) / 2;
+                if (comp(seq.Get(middle), value))
+                    low = middle + 1;
+                else
+                    high = middle;
+            }
+            return low;
+        } else {
+            int index = 0;
+            for (auto it = seq.cbegin(), end = seq.cend(); it != end && comp(*it, value); ++it)
+                ++index;
+            return index;
+        }
+    }
+
+    // Index of an item equal to value in a sorted sequence, -1 when there is none
+    template <typename Seq, typename Compare = std::less<typename Seq::value_type>>
+    int BinarySearch(const Seq& seq, const typename Seq::value_type& value, Compare comp = Compare()) {
+        int index = LowerBound(seq, value, comp);
+        if (index == seq.GetSize() || comp(value, seq.Get(index)))
+            return -1;
+        return index;
+    }
+
+    // New array of f applied to every item, in order
+    template <typename Policy, typename Seq, typename F>
+    auto Map(const Policy& policy, const Seq& seq, F f) -> ArraySequence<typename std::decay<decltype(f(*seq.cbegin()))>::type>* {
+        using R = typename std::decay<decltype(f(*seq.cbegin()))>::type;
+        int count = seq.GetSize();
+        int parts = Algorithms::Parts(policy, count);
+        if (parts <= 1) {
+            ArraySequence<R>* result = new ArraySequence<R>();
+            result->Reserve(count);
+            seq.ForEach([&](const typename Seq::value_type& item) { result->Emplace(f(item)); });
+            return result;
+        }
+        Algorithms::Items<Seq> items(seq);
+        ArraySequence<R>* result = new ArraySequence<R>(count);
+        R* out = result->begin();
+        try {
+            Algorithms::ForParts(count, parts, [&](int, long long begin, long long end) {
+                for (long long i = begin; i < end; ++i)
+                    out[i] = f(items[i]);
+            });
+        } catch (...) {
+            delete result;
+            throw;
+        }
+        return result;
+    }
+    template <typename Seq, typename F>
+    auto Map(const Seq& seq, F f) -> decltype(Map(Sequential, seq, f)) {
+        return Map(Sequential, seq, f);
+    }
+
+    // Left fold with op, init used once. The parallel fold gives every chunk its own accumulator, a
+    // copy of init, folds the chunk into it with op and then folds the partial results in order with
+    // combine. So init has to be an identity of combine (0 for a sum) and combine associative, with
+    // combine(a, fold of a chunk from init) equal to the fold of that chunk from a
+    template <typename Seq, typename U, typename Op>
+    U Reduce(SequentialExecution, const Seq& seq, U init, Op op) {
+        return seq.Reduce(std::move(init), op);
+    }
+    template <typename Seq, typename U, typename Op, typename Combine>
+    U Reduce(SequentialExecution, const Seq& seq, U init, Op op, Combine) {
+        return seq.Reduce(std::move(init), op);
+    }
+    template <typename Seq, typename U, typename Op, typename Combine>
+    U Reduce(ParallelExecution policy, const Seq& seq, U init, Op op, Combine combine) {
+        int count = seq.GetSize();
+        int parts = Algorithms::Parts(policy, count);
+        if (parts <= 1)
+            return seq.Reduce(std::move(init), op);
+        Algorithms::Items<Seq> items(seq);
+        std::vector<U> partial(parts, init);
+        Algorithms::ForParts(count, parts, [&](int part, long long begin, long long end) {
+            U acc = std::move(partial[part]);
+            for (long long i = begin; i < end; ++i)
+                acc = op(std::move(acc), items[i]);
+            partial[part] = std::move(acc);
+        });
+        U result = std::move(partial[0]);
+        for (int part = 1; part < parts; ++part)
+            result = combine(std::move(result), std::move(partial[part]));
+        return result;
+    }
+    // Without combine op merges the partial results too, which only makes sense when the
+    // accumulator has the type of the items
+    template <typename Seq, typename U, typename Op>
+    U Reduce(ParallelExecution policy, const Seq& seq, U init, Op op) {
+        static_assert(std::is_same<U, typename Seq::value_type>::value,
+                      "A parallel fold into another type needs a combine for the partial results");
+        return Reduce(policy, seq, std::move(init), op, op);
+    }
+    template <typename Seq, typename U, typename Op>
+    U Reduce(const Seq& seq, U init, Op op) {
+        return Reduce(Sequential, seq, std::move(init), op);
+    }
+
+    // New array of the items that satisfy pred, in order
+    template <typename Policy, typename Seq, typename Pred>
+    ArraySequence<typename Seq::value_type>* Filter(const Policy& policy, const Seq& seq, Pred pred) {
+        using T = typename Seq::value_type;
+        int count = seq.GetSize();
+        int parts = Algorithms::Parts(policy, count);
+        ArraySequence<T>* result = new ArraySequence<T>();
+        try {
+            if (parts <= 1) {
+                seq.ForEach([&](const T& item) {
+                    if (pred(item))
+                        result->Emplace(item);
+                });
+                return result;
+            }
+            Algorithms::Items<Seq> items(seq);
+            std::vector<DynamicArray<T>> kept(parts);
+            Algorithms::ForParts(count, parts, [&](int part, long long begin, long long end) {
+                for (long long i = begin; i < end; ++i)
+                    if (pred(items[i]))
+                        kept[part].Emplace(items[i]);
+            });
+            long long total = 0;
+            for (const DynamicArray<T>& chunk : kept)
+                total += chunk.GetSize();
+            result->Reserve(static_cast<int>(total));
+            for (const DynamicArray<T>& chunk : kept)
+                result->AppendRange(chunk.cbegin(), chunk.cend());
+        } catch (...) {
+            delete result;
+            throw;
+        }
+        return result;
+    }
+    template <typename Seq, typename Pred>
+    ArraySequence<typename Seq::value_type>* Filter(const Seq& seq, Pred pred) {
+        return Filter(Sequential, seq, pred);
+    }
+}
@@ -0,0 +1,717 @@
+#include <iostream>
+#include <new>
+#include <memory>
+#include <cstddef>
+#include <cmath>
+#include <iomanip>
+#include <limits>
+#include <algorithm>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <exception>
+#include <fstream>
+#include <cstdint>
+#include <cstring>
+#include <cerrno>
+#include <cstdio>
+#include <chrono>
+#include <string>
+#include <cstdlib>
+#include "exceptions.hpp"
+#include "dynamic_array.hpp"
+#include "node_pool.hpp"
+#include "linked_list.hpp"
+#include "sequence.hpp"
+#include "rope_sequence.hpp"
+#include "thread_pool.hpp"
+#include "algorithms.hpp"
+#include "simd_kernels.hpp"
+#include "triangle_storage.hpp"
+#include "triangle_expression.hpp"
+#include "triangle_matrix.hpp"
+#include "serialization.hpp"
+
+// Every allocation of the process goes through here, so a benchmark can count the ones it makes
+static std::atomic<long long> allocations{0};
+
+void* operator new(std::size_t size) {
+    ++allocations;
+    if (void* ptr = std::malloc(size ? size : 1))
+        return ptr;
+    throw std::bad_alloc();
+}
+// GCC can't tell that new above is malloc and warns about every delete it inlines
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+void operator delete(void* ptr, std::size_t) noexcept {
+    std::free(ptr);
+}
+#pragma GCC diagnostic pop
+
+template <typename F>
+long long measure(F f) {
+    auto start = std::chrono::high_resolution_clock::now();
+    f();
+    auto stop = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration_cast<std::chrono::microseconds>(stop - start).count();
+}
+
+void report(const std::string &name, int n, long long us) {
+    std::cout << std::setiosflags(std::ios::left) << std::setw(40) << name
+              << std::setw(10) << n << std::setw(14) << (std::to_string(us) + " us")
+              << "  (" << (us ? (long long)(n / (us / 1e6)) : 0) << " ops/s)" << std::endl;
+}
+
+void benchAppend() {
+    std::cout << std::endl << "APPEND THROUGHPUT:" << std::endl;
+    for (int n : {1000, 100000, 1000000}) {
+        report("std::vector::push_back", n, measure([n] {
+            std::vector<int> v;
+            for (int i = 0; i < n; ++i)
+                v.push_back(i);
+        }));
+        report("Lab::ArraySequence::Append", n, measure([n] {
+            Lab::ArraySequence<int> s;
+            for (int i = 0; i < n; ++i)
+                s.Append(i);
+        }));
+        report("Lab::ArraySequence::Append (x1.5)", n, measure([n] {
+            Lab::ArraySequence<int> s;
+            s.getptr()->SetGrowthFactor(1.5);
+            for (int i = 0; i < n; ++i)
+                s.Append(i);
+        }));
+        report("Lab::ArraySequence::Append (reserved)", n, measure([n] {
+            Lab::ArraySequence<int> s;
+            s.Reserve(n);
+            for (int i = 0; i < n; ++i)
+                s.Append(i);
+        }));
+    }
+}
+
+void benchStrings() {
+    std::cout << std::endl << "STRING PAYLOADS:" << std::endl;
+    const std::string payload(64, 'x');
+    for (int n : {1000, 20000}) {
+        report("ArraySequence<string>::Append(copy)", n, measure([&] {
+            Lab::ArraySequence<std::string> s;
+            for (int i = 0; i < n; ++i) {
+                std::string item = payload;
+                s.Append(item);
+            }
+        }));
+        report("ArraySequence<string>::Append(move)", n, measure([&] {
+            Lab::ArraySequence<std::string> s;
+            for (int i = 0; i < n; ++i) {
+                std::string item = payload;
+                s.Append(std::move(item));
+            }
+        }));
+        report("ArraySequence<string>::Emplace", n, measure([&] {
+            Lab::ArraySequence<std::string> s;
+            for (int i = 0; i < n; ++i)
+                s.Emplace(64, 'x');
+        }));
+        report("ListSequence<string>::Emplace", n, measure([&] {
+            Lab::ListSequence<std::string> s;
+            for (int i = 0; i < n; ++i)
+                s.Emplace(64, 'x');
+        }));
+        Lab::ArraySequence<std::string> source;
+        for (int i = 0; i < n; ++i)
+            source.Emplace(payload);
+        report("ArraySequence<string> copy", n, measure([&] {
+            Lab::ArraySequence<std::string> copy(source);
+        }));
+        report("ArraySequence<string> move", n, measure([&] {
+            Lab::ArraySequence<std::string> moved(std::move(source));
+        }));
+    }
+}
+
+void benchListScaling() {
+    std::cout << std::endl << "LIST SCALING:" << std::endl;
+    for (int n : {1000, 10000, 100000, 1000000, 10000000}) {
+        Lab::ListSequence<int> a, b;
+        report("ListSequence::Append", n, measure([&] {
+            for (int i = 0; i < n; ++i)
+                a.Append(i);
+        }));
+        for (int i = 0; i < n; ++i)
+            b.Append(i);
+        long long last = 0;
+        report("ListSequence::GetLast", n, measure([&] {
+            for (int i = 0; i < n; ++i)
+                last += a.GetLast();
+        }));
+        Lab::ListSequence<int> *c = nullptr;
+        report("ListSequence::Concat (n + n)", n, measure([&] {
+            c = a.Concat(b);
+        }));
+        delete c;
+        if (last == 42)
+            std::cout << std::endl;
+    }
+}
+
+template <typename Allocator>
+void benchListAllocator(const std::string &name, int n) {
+    auto *list = new Lab::LinkedList<int, Allocator>();
+    report(name + " build", n, measure([&] {
+        for (int i = 0; i < n; ++i)
+            list->Append(i);
+    }));
+    Lab::LinkedList<int, Allocator> *copy = nullptr;
+    report(name + " copy", n, measure([&] {
+        copy = new Lab::LinkedList<int, Allocator>(*list);
+    }));
+    report(name + " destroy", n, measure([&] {
+        delete list;
+        delete copy;
+    }));
+}
+
+void benchListPool() {
+    std::cout << std::endl << "LIST NODE ALLOCATION:" << std::endl;
+    for (int n : {100000, 1000000, 10000000}) {
+        benchListAllocator<std::allocator<int>>("LinkedList<std::allocator>", n);
+        benchListAllocator<Lab::PoolAllocator<int>>("LinkedList<PoolAllocator>", n);
+    }
+}
+
+__attribute__((noinline)) long long sumVirtualGet(const Lab::Sequence<long long> &seq) {
+    long long sum = 0;
+    for (int i = 0; i < seq.GetSize(); ++i)
+        sum += seq.Get(i);
+    return sum;
+}
+
+__attribute__((noinline)) long long sumVirtualIterator(const Lab::Sequence<long long> &seq) {
+    long long sum = 0;
+    for (const long long &item : seq)
+        sum += item;
+    return sum;
+}
+
+template <typename Derived>
+__attribute__((noinline)) long long sumStatic(const Lab::StaticSequence<Derived, long long> &seq) {
+    return Lab::Sum(seq);
+}
+
+__attribute__((noinline)) long long scanVirtualGet(const Lab::Sequence<long long> &seq, Lab::ArraySequence<long long> &out) {
+    long long acc = 0;
+    for (int i = 0; i < seq.GetSize(); ++i) {
+        acc += seq.Get(i);
+        out.Append(acc);
+    }
+    return acc;
+}
+
+void benchDispatch() {
+    std::cout << std::endl << "SUM/SCAN DISPATCH:" << std::endl;
+    const int n = 10000000;
+    Lab::ArraySequence<long long> arr;
+    Lab::ListSequence<long long> list;
+    for (int i = 0; i < n; ++i) {
+        arr.Append(i);
+        list.Append(i);
+    }
+    long long check = 0;
+    report("ArraySequence sum, virtual Get", n, measure([&] { check += sumVirtualGet(arr); }));
+    report("ArraySequence sum, Sequence iterator", n, measure([&] { check += sumVirtualIterator(arr); }));
+    report("ArraySequence sum, StaticSequence", n, measure([&] { check += sumStatic(arr); }));
+    report("ListSequence sum, Sequence iterator", n, measure([&] { check += sumVirtualIterator(list); }));
+    report("ListSequence sum, StaticSequence", n, measure([&] { check += sumStatic(list); }));
+    report("ArraySequence scan, virtual Get", n, measure([&] {
+        Lab::ArraySequence<long long> out;
+        out.Reserve(n);
+        check += scanVirtualGet(arr, out);
+    }));
+    report("ArraySequence scan, StaticSequence", n, measure([&] {
+        Lab::ArraySequence<long long> *out = Lab::Scan(arr);
+        check += out->GetLast();
+        delete out;
+    }));
+    report("ListSequence scan, StaticSequence", n, measure([&] {
+        Lab::ArraySequence<long long> *out = Lab::Scan(list);
+        check += out->GetLast();
+        delete out;
+    }));
+    std::cout << "(checksum " << check << ")" << std::endl;
+}
+
+template <template <typename> class Storage>
+void benchTriangleStorage(const std::string &name, int n) {
+    long long cells = (long long)n * (n + 1) / 2;
+    Lab::Triangle_Matrix<double, Storage> *a = nullptr, *b = nullptr;
+    report(name + " construct", cells, measure([&] {
+        a = new Lab::Triangle_Matrix<double, Storage>(n, true);
+        b = new Lab::Triangle_Matrix<double, Storage>(n, true);
+    }));
+    report(name + " Fill", cells, measure([&] { a->Fill(1.5); b->Fill(0.5); }));
+    report(name + " Sum", cells, measure([&] { a->Sum(b); }));
+    report(name + " Scalar", cells, measure([&] { a->Scalar(2.0); }));
+    double norme = 0;
+    report(name + " GetNorme", cells, measure([&] { norme = a->GetNorme(); }));
+    report(name + " Get(i, j) on diagonal", n, measure([&] {
+        for (int i = 0; i < n; ++i)
+            norme += a->Get(i, i);
+    }));
+    std::cout << "(norme " << norme << ")" << std::endl;
+    delete a;
+    delete b;
+}
+
+void benchTriangle() {
+    std::cout << std::endl << "TRIANGLE MATRIX STORAGE:" << std::endl;
+    for (int n : {500, 2000}) {
+        benchTriangleStorage<Lab::ListTriangleStorage>("List n=" + std::to_string(n), n);
+        benchTriangleStorage<Lab::PackedTriangleStorage>("Packed n=" + std::to_string(n), n);
+    }
+    benchTriangleStorage<Lab::PackedTriangleStorage>("Packed n=10000", 10000);
+}
+
+template <typename T>
+void benchKernelsFor(const std::string &type, int n) {
+    long long cells = (long long)n * (n + 1) / 2;
+    Lab::Triangle_Matrix<T> a(n, true), b(n, true);
+    a.Fill(T(3));
+    b.Fill(T(1));
+    const std::pair<Lab::Kernels::Level, std::string> levels[] = {
+        {Lab::Kernels::Level::Scalar, "scalar"}, {Lab::Kernels::Level::SSE2, "sse2"}, {Lab::Kernels::Level::AVX2, "avx2"}};
+    double norme = 0;
+    for (const auto &level : levels) {
+        Lab::Kernels::SetLevel(level.first);
+        if (Lab::Kernels::GetLevel() != level.first)
+            continue;
+        std::string name = type + " " + level.second + " n=" + std::to_string(n);
+        report(name + " Sum", cells, measure([&] { a.Sum(&b); }));
+        report(name + " Scalar", cells, measure([&] { a.Scalar(T(-1)); }));
+        report(name + " GetNorme", cells, measure([&] { norme += a.GetNorme(); }));
+    }
+    Lab::Kernels::SetLevel(Lab::Kernels::DetectLevel());
+    std::cout << "(norme " << norme << ")" << std::endl;
+}
+
+void benchKernels() {
+    std::cout << std::endl << "TRIANGLE MATRIX KERNELS:" << std::endl;
+    for (int n : {2000, 10000}) {
+        benchKernelsFor<double>("double", n);
+        benchKernelsFor<float>("float", n);
+        benchKernelsFor<int>("int", n);
+    }
+}
+
+void reportFlops(const std::string &name, int n, double flops, long long us) {
+    std::cout << std::setiosflags(std::ios::left) << std::setw(40) << name
+              << std::setw(10) << n << std::setw(14) << (std::to_string(us) + " us")
+              << "  (" << (us ? flops / (us * 1e3) : 0) << " GFLOP/s)" << std::endl;
+}
+
+template <typename T>
+void benchProductsFor(const std::string &type, int n, bool upper, int threads) {
+    Lab::Triangle_Matrix<T> a(n, upper), b(n, upper);
+    a.Fill(T(1));
+    b.Fill(T(1));
+    for (int i = 0; i < n; ++i)
+        a.Set(T(n), i, i);
+    Lab::ArraySequence<T> x(n);
+    for (int i = 0; i < n; ++i)
+        x.Set(T(1), i);
+    // Only the stored cells count: n(n+1) flops for A * x and the solve, n(n+1)(n+2)/3 for A * B
+    double cells = (double)n * (n + 1);
+    std::string name = type + (upper ? " upper" : " lower") + " t=" + std::to_string(threads);
+    Lab::ArraySequence<T> *y = nullptr, *s = nullptr;
+    reportFlops(name + " Multiply(x)", n, cells, measure([&] { y = a.Multiply(x, threads); }));
+    reportFlops(name + " Solve(b)", n, cells, measure([&] { s = a.Solve(*y); }));
+    Lab::Triangle_Matrix<T> *c = nullptr;
+    reportFlops(name + " Multiply(B)", n, cells * (n + 2) / 3, measure([&] { c = a.Multiply(&b, threads); }));
+    std::cout << "(check " << s->Get(n / 2) << " " << c->Get(n / 2, n / 2) << ")" << std::endl;
+    delete y;
+    delete s;
+    delete c;
+}
+
+void benchProducts() {
+    std::cout << std::endl << "TRIANGLE MATRIX PRODUCTS:" << std::endl;
+    int cores = std::max(1u, std::thread::hardware_concurrency());
+    for (int n : {500, 2000}) {
+        for (int threads : {1, cores}) {
+            benchProductsFor<double>("double n=" + std::to_string(n), n, true, threads);
+            benchProductsFor<double>("double n=" + std::to_string(n), n, false, threads);
+            benchProductsFor<float>("float n=" + std::to_string(n), n, true, threads);
+            if (cores == 1)
+                break;
+        }
+    }
+}
+
+void benchScaling() {
+    std::cout << std::endl << "TRIANGLE MATRIX THREAD SCALING:" << std::endl;
+    const int n = 10000;
+    long long cells = (long long)n * (n + 1) / 2;
+    int cores = std::max(1u, std::thread::hardware_concurrency());
+    for (int threads = 1; threads <= cores; ++threads) {
+        Lab::ThreadPool::SetDefaultThreads(threads);
+        std::string name = "Packed n=" + std::to_string(n) + " t=" + std::to_string(threads);
+        Lab::Triangle_Matrix<double> a(n, true), b(n, true);
+        report(name + " Fill", cells, measure([&] { a.Fill(1.5); b.Fill(0.5); }));
+        report(name + " Sum", cells, measure([&] { a.Sum(&b); }));
+        report(name + " Scalar", cells, measure([&] { a.Scalar(-1.0); }));
+        double norme = 0;
+        report(name + " GetNorme", cells, measure([&] { norme = a.GetNorme(); }));
+        std::cout << "(norme " << norme << ")" << std::endl;
+    }
+    Lab::ThreadPool::SetDefaultThreads(0);
+}
+
+void benchExpressions() {
+    std::cout << std::endl << "TRIANGLE MATRIX EXPRESSIONS:" << std::endl;
+    for (int n : {2000, 10000}) {
+        long long cells = (long long)n * (n + 1) / 2;
+        std::string name = "n=" + std::to_string(n);
+        Lab::Triangle_Matrix<double> a(n, true), b(n, true), c(n, true);
+        a.Fill(1.5);
+        b.Fill(0.5);
+        report(name + " copy, Sum, Scalar", cells, measure([&] {
+            c = a;
+            c.Sum(&b)->Scalar(2.0);
+        }));
+        report(name + " c = (a + b) * 2", cells, measure([&] { c = (a + b) * 2.0; }));
+        report(name + " Sum, Sum, Scalar in place", cells, measure([&] { a.Sum(&b)->Sum(&c)->Scalar(0.5); }));
+        report(name + " a = (a + b + c) * 0.5", cells, measure([&] { a = (a + b + c) * 0.5; }));
+        std::cout << "(check " << a.Get(0, n - 1) + c.Get(0, n - 1) << ")" << std::endl;
+    }
+}
+
+void benchSerialization() {
+    std::cout << std::endl << "TRIANGLE MATRIX FILES:" << std::endl;
+    const std::string path = "bench_triangle.bin";
+    for (int n : {2000, 8000}) {
+        long long cells = (long long)n * (n + 1) / 2;
+        std::string name = "n=" + std::to_string(n);
+        Lab::Triangle_Matrix<double> a(n, true);
+        a.Fill(0.5);
+        report(name + " Save", cells, measure([&] { Lab::Save(a, path); }));
+        const Lab::Triangle_Matrix<double> *loaded = nullptr;
+        report(name + " LoadTriangleMatrix (mmap)", cells, measure([&] { loaded = Lab::LoadTriangleMatrix<double>(path); }));
+        double norme = 0;
+        report(name + " GetNorme on mapped pages", cells, measure([&] { norme += loaded->GetNorme(); }));
+        delete loaded;
+        report(name + " interface-style Set per cell", cells, measure([&] {
+            Lab::Triangle_Matrix<double> b(n, true);
+            for (int i = 0; i < n; ++i)
+                for (int j = i; j < n; ++j)
+                    b.Set(0.5, i, j);
+            norme += b.Get(0, 0);
+        }));
+        std::cout << "(norme " << norme << ")" << std::endl;
+    }
+    std::remove(path.c_str());
+}
+
+template <template <typename> class Storage>
+void benchSparseStorage(const std::string &name, const Lab::Triangle_Matrix<double> &dense, const Lab::ArraySequence<double> &x) {
+    int n = dense.GetSize();
+    Lab::Triangle_Matrix<double, Storage> *a = nullptr;
+    report(name + " convert from dense", n, measure([&] { a = new Lab::Triangle_Matrix<double, Storage>(dense); }));
+    Lab::Triangle_Matrix<double, Storage> b(*a);
+    report(name + " Sum", n, measure([&] { a->Sum(&b); }));
+    report(name + " Scalar", n, measure([&] { a->Scalar(0.5); }));
+    double check = 0;
+    report(name + " GetNorme", n, measure([&] { check += a->GetNorme(); }));
+    Lab::ArraySequence<double> *y = nullptr, *z = nullptr;
+    report(name + " Multiply(x)", n, measure([&] { y = a->Multiply(x); }));
+    report(name + " Solve(b)", n, measure([&] { z = a->Solve(*y); }));
+    std::cout << "(check " << check + z->Get(n / 2) << ")" << std::endl;
+    delete y;
+    delete z;
+    delete a;
+}
+
+void benchSparse() {
+    std::cout << std::endl << "SPARSE TRIANGLE MATRIX:" << std::endl;
+    const int n = 5000;
+    for (int perMille : {1, 10, 100}) {
+        Lab::Triangle_Matrix<double> dense(n, false);
+        unsigned seed = 12345;
+        for (int i = 0; i < n; ++i) {
+            dense.Set(2.0, i, i);
+            for (int j = 0; j < i; ++j) {
+                seed = seed * 1103515245 + 12345;
+                if ((seed >> 8) % 1000 < (unsigned)perMille)
+                    dense.Set(0.25, i, j);
+            }
+        }
+        Lab::ArraySequence<double> x(n);
+        for (int i = 0; i < n; ++i)
+            x.Set(1.0, i);
+        std::string density = (perMille < 10 ? "0." + std::to_string(perMille) : std::to_string(perMille / 10)) + "%";
+        benchSparseStorage<Lab::PackedTriangleStorage>("Packed " + density, dense, x);
+        benchSparseStorage<Lab::CsrTriangleStorage>("Csr " + density, dense, x);
+    }
+}
+
+template <typename Check>
+void benchChecksFor(const std::string &name, int n) {
+    Lab::DynamicArray<long long, Check> array(n);
+    for (int i = 0; i < n; ++i)
+        array[i] = i;
+    long long sum = 0;
+    report(name + " DynamicArray::Get", n, measure([&] {
+        for (int i = 0; i < n; ++i)
+            sum += array.Get(i);
+    }));
+    report(name + " DynamicArray::operator[]", n, measure([&] {
+        for (int i = 0; i < n; ++i)
+            array[i] += 1;
+    }));
+    const int m = 512;
+    Lab::Triangle_Matrix<double, Lab::PackedTriangleStorage, Check> matrix(m, false);
+    double trace = 0;
+    report(name + " Triangle_Matrix::operator()", m * (m + 1) / 2, measure([&] {
+        for (int i = 0; i < m; ++i)
+            for (int j = 0; j <= i; ++j)
+                matrix(i, j) = i - j;
+    }));
+    report(name + " Triangle_Matrix::Get", m * (m + 1) / 2, measure([&] {
+        for (int i = 0; i < m; ++i)
+            for (int j = 0; j <= i; ++j)
+                trace += matrix.Get(i, j);
+    }));
+    std::cout << "(sum " << sum + array.Get(n - 1) << ", " << trace << ")" << std::endl;
+}
+
+template <typename Seq>
+void benchSmallFor(const std::string &name, int count, int length) {
+    long long before = allocations;
+    long long sum = 0;
+    long long us = measure([&] {
+        for (int k = 0; k < count; ++k) {
+            Seq seq;
+            for (int i = 0; i < length; ++i)
+                seq.Append(i);
+            sum += seq.GetLast();
+        }
+    });
+    report(name + " x" + std::to_string(length), count, us);
+    std::cout << "    " << std::fixed << std::setprecision(2) << double(allocations - before) / count
+              << " allocations per sequence (sum " << sum << ")" << std::defaultfloat << std::endl;
+}
+
+void benchSmall() {
+    std::cout << std::endl << "SMALL SEQUENCES:" << std::endl;
+    for (int length : {4, 16, 64}) {
+        benchSmallFor<Lab::ArraySequence<int>>("ArraySequence", 200000, length);
+        benchSmallFor<Lab::SmallArraySequence<int, 16>>("SmallArraySequence<16>", 200000, length);
+    }
+}
+
+template <typename Seq>
+void benchMiddleInsertsFor(const std::string &name, int n) {
+    Seq seq;
+    report(name + " InsertAt middle", n, measure([&] {
+        for (int i = 0; i < n; ++i) {
+            if (seq.GetSize() < 2)
+                seq.Append(i);
+            else
+                seq.InsertAt(i, seq.GetSize() / 2);
+        }
+    }));
+    long long sum = 0;
+    report(name + " Get", n, measure([&] {
+        for (int i = 0; i < n; ++i)
+            sum += seq.Get(i);
+    }));
+    Lab::Sequence<int> *sub = nullptr, *both = nullptr;
+    report(name + " GetSubSequence + Concat", 100, measure([&] {
+        for (int k = 0; k < 100; ++k) {
+            sub = seq.GetSubSequence(n / 4, n - n / 4);
+            both = sub->Concat(seq);
+            sum += both->GetSize();
+            delete sub;
+            delete both;
+        }
+    }));
+    std::cout << "(sum " << sum << ")" << std::endl;
+}
+
+void benchRope() {
+    std::cout << std::endl << "MIDDLE INSERTS AND CONCAT:" << std::endl;
+    for (int n : {10000, 100000}) {
+        benchMiddleInsertsFor<Lab::ArraySequence<int>>("ArraySequence", n);
+        if (n <= 10000)
+            benchMiddleInsertsFor<Lab::ListSequence<int>>("ListSequence", n);
+        benchMiddleInsertsFor<Lab::RopeSequence<int>>("RopeSequence", n);
+    }
+}
+
+void benchViews() {
+    std::cout << std::endl << "COPIES, SLICES AND VIEWS:" << std::endl;
+    const int n = 1000000, rounds = 1000;
+    Lab::ArraySequence<int> seq(n);
+    std::vector<int> vec(n);
+    long long sum = 0;
+    report("std::vector copy", rounds / 100, measure([&] {
+        for (int k = 0; k < rounds / 100; ++k) {
+            std::vector<int> copy = vec;
+            sum += copy[k];
+        }
+    }));
+    report("Lab::ArraySequence copy", rounds, measure([&] {
+        for (int k = 0; k < rounds; ++k) {
+            Lab::ArraySequence<int> copy = seq;
+            sum += copy.Get(k);
+        }
+    }));
+    report("Lab::ArraySequence copy + Set", rounds / 100, measure([&] {
+        for (int k = 0; k < rounds / 100; ++k) {
+            Lab::ArraySequence<int> copy = seq;
+            copy.Set(k, k);
+            sum += copy.Get(k);
+        }
+    }));
+    report("Lab::ArraySequence::GetSubSequence", rounds, measure([&] {
+        for (int k = 0; k < rounds; ++k) {
+            Lab::ArraySequence<int> *sub = seq.GetSubSequence(k, n - k);
+            sum += sub->GetFirst();
+            delete sub;
+        }
+    }));
+    report("Lab::Sequence::View", rounds, measure([&] {
+        for (int k = 0; k < rounds; ++k)
+            sum += seq.View(k, n - k).GetFirst();
+    }));
+    std::cout << "(sum " << sum << ")" << std::endl;
+}
+
+template <typename Seq>
+void benchBulkFor(const std::string &name, int n, int k) {
+    std::vector<int> items(k, 7);
+    Seq one, bulk;
+    one.AppendRange(items);
+    bulk.AppendRange(items);
+    for (int i = 0; i < n / k; ++i) {
+        one.AppendRange(items);
+        bulk.AppendRange(items);
+    }
+    report(name + " InsertAt x" + std::to_string(k), k, measure([&] {
+        for (int i = 0; i < k; ++i)
+            one.InsertAt(items[i], n / 2 + i);
+    }));
+    report(name + " InsertRange of " + std::to_string(k), k, measure([&] {
+        bulk.InsertRange(n / 2, items.begin(), items.end());
+    }));
+    report(name + " Append x" + std::to_string(k), k, measure([&] {
+        for (int i = 0; i < k; ++i)
+            one.Append(items[i]);
+    }));
+    report(name + " AppendRange of " + std::to_string(k), k, measure([&] {
+        bulk.AppendRange(items);
+    }));
+    std::cout << "(sizes " << one.GetSize() << " " << bulk.GetSize() << ")" << std::endl;
+}
+
+void benchBulk() {
+    std::cout << std::endl << "BULK INSERTION:" << std::endl;
+    benchBulkFor<Lab::ArraySequence<int>>("ArraySequence", 1000000, 1000);
+    benchBulkFor<Lab::ListSequence<int>>("ListSequence", 100000, 1000);
+    benchBulkFor<Lab::RopeSequence<int>>("RopeSequence", 1000000, 1000);
+}
+
+template <typename Seq>
+void benchAlgorithmsFor(const std::string &name, int n, int probes) {
+    Seq seq;
+    unsigned state = 12345;
+    for (int i = 0; i < n; ++i) {
+        state = state * 1103515245u + 12345u;
+        seq.Append(int(state >> 8));
+    }
+    long long sum = 0;
+    auto plus = [](long long acc, long long item) { return acc + item; };
+    report(name + " Reduce", n, measure([&] { sum += Lab::Reduce(seq, 0LL, plus); }));
+    report(name + " Reduce parallel", n, measure([&] { sum += Lab::Reduce(Lab::Parallel, seq, 0LL, plus, plus); }));
+    report(name + " Map", n, measure([&] {
+        Lab::ArraySequence<double> *mapped = Lab::Map(seq, [](int item) { return item * 0.5; });
+        sum += mapped->GetSize();
+        delete mapped;
+    }));
+    report(name + " Map parallel", n, measure([&] {
+        Lab::ArraySequence<double> *mapped = Lab::Map(Lab::Parallel, seq, [](int item) { return item * 0.5; });
+        sum += mapped->GetSize();
+        delete mapped;
+    }));
+    report(name + " Filter parallel", n, measure([&] {
+        Lab::ArraySequence<int> *kept = Lab::Filter(Lab::Parallel, seq, [](int item) { return item % 3 == 0; });
+        sum += kept->GetSize();
+        delete kept;
+    }));
+    Seq parallel = seq;
+    report(name + " Sort", n, measure([&] { Lab::Sort(seq); }));
+    report(name + " Sort parallel", n, measure([&] { Lab::Sort(Lab::Parallel, parallel); }));
+    report(name + " BinarySearch", probes, measure([&] {
+        for (int i = 0; i < probes; ++i)
+            sum += Lab::BinarySearch(seq, int(i * 2654435761u >> 8));
+    }));
+    std::cout << "(sum " << sum << ")" << std::endl;
+}
+
+void benchAlgorithms() {
+    std::cout << std::endl << "ALGORITHMS (" << Lab::ThreadPool::Default().GetThreadCount() << " threads):" << std::endl;
+    const int n = 1000000;
+    benchAlgorithmsFor<Lab::ArraySequence<int>>("ArraySequence", n, 100000);
+    benchAlgorithmsFor<Lab::ListSequence<int>>("ListSequence", n, 10);
+    benchAlgorithmsFor<Lab::RopeSequence<int>>("RopeSequence", n, 100000);
+
+    // What callers wrote before: an index loop, each Get walking the list from the head
+    const int m = 20000;
+    Lab::ListSequence<int> list;
+    for (int i = 0; i < m; ++i)
+        list.Append(m - i);
+    long long sum = 0;
+    report("ListSequence Get loop sum", m, measure([&] {
+        for (int i = 0; i < list.GetSize(); ++i)
+            sum += list.Get(i);
+    }));
+    report("ListSequence Reduce sum", m, measure([&] {
+        sum += Lab::Reduce(list, 0LL, [](long long acc, int item) { return acc + item; });
+    }));
+    std::cout << "(sum " << sum << ")" << std::endl;
+}
+
+void benchChecks() {
+    std::cout << std::endl << "BOUNDS CHECK POLICIES:" << std::endl;
+    benchChecksFor<Lab::Checked>("Checked", 10000000);
+    benchChecksFor<Lab::Unchecked>("Unchecked", 10000000);
+}
+
+int main () {
+    benchAppend();
+    benchStrings();
+    benchListScaling();
+    benchListPool();
+    benchDispatch();
+    benchTriangle();
+    benchKernels();
+    benchProducts();
+    benchScaling();
+    benchExpressions();
+    benchSerialization();
+    benchSparse();
+    benchChecks();
+    benchSmall();
+    benchRope();
+    benchViews();
+    benchBulk();
+    benchAlgorithms();
+    return 0;
+}
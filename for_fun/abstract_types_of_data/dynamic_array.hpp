@@ -1,78 +1,400 @@
 namespace Lab {
-    template <class T>
+    template <class T, class Check = Lab::Checked>
     class DynamicArray {
         T* arr;
         int size = 0;
+        int capacity = 0;
+        double growthFactor = 2.0;
+        // Set when arr is borrowed: the items belong to whatever keeper holds, not to this array
+        std::shared_ptr<const void> keeper;
+
+        // Storage is raw memory: only the first size slots hold constructed objects
+        static T* Allocate(int count, const char *what) {
+            if (count == 0)
+                return nullptr;
+            void *ptr;
+            if (alignof(T) > __STDCPP_DEFAULT_NEW_ALIGNMENT__)
+                ptr = ::operator new(sizeof(T) * count, std::align_val_t(alignof(T)), std::nothrow);
+            else
+                ptr = ::operator new(sizeof(T) * count, std::nothrow);
+            if (!ptr)
+                throw std::runtime_error(std::string("Allocation during ") + what + " failed");
+            return static_cast<T*>(ptr);
+        }
+        static void Deallocate(T* ptr) {
+            if (alignof(T) > __STDCPP_DEFAULT_NEW_ALIGNMENT__)
+                ::operator delete(ptr, std::align_val_t(alignof(T)));
+            else
+                ::operator delete(ptr);
+        }
+        // Falls back to copying when a throwing move could lose elements halfway
+        static void Relocate(T* from, int count, T* to) {
+            if (std::is_nothrow_move_constructible<T>::value || !std::is_copy_constructible<T>::value)
+                std::uninitialized_move_n(from, count, to);
+            else
+                std::uninitialized_copy_n(from, count, to);
+        }
+        // Borrowed items are copied out, the keeper may share them with other arrays
+        void Take(T* from, int count, T* to) const {
+            if constexpr (std::is_copy_constructible<T>::value)
+                if (keeper) {
+                    std::uninitialized_copy_n(from, count, to);
+                    return;
+                }
+            Relocate(from, count, to);
+        }
+        // True when some item of [first, last) is one of the items of this array
+        template <typename It>
+        bool Aliases(It first, It last) const {
+            using Reference = typename std::iterator_traits<It>::reference;
+            if constexpr (std::is_lvalue_reference<Reference>::value
+                          && std::is_same<typename std::decay<Reference>::type, T>::value) {
+                std::less<const T*> less;
+                for (; first != last; ++first) {
+                    const T* item = std::addressof(*first);
+                    if (!less(item, arr) && less(item, arr + size))
+                        return true;
+                }
+            }
+            return false;
+        }
+        void Reallocate(int newCapacity) {
+            T* ptr = Allocate(newCapacity, "Resize");
+            try {
+                Take(arr, size, ptr);
+            } catch (...) {
+                Deallocate(ptr);
+                throw;
+            }
+            if (keeper) {
+                keeper.reset();
+            } else {
+                std::destroy_n(arr, size);
+                Deallocate(arr);
+            }
+            arr = ptr;
+            capacity = newCapacity;
+        }
+        void Grow(int minCapacity) {
+            int grown = static_cast<int>(std::min<double>(capacity * growthFactor, std::numeric_limits<int>::max()));
+            Reallocate(std::max(minCapacity, grown));
+        }
     public:
-        DynamicArray() : size(0), arr(nullptr) {}
-        DynamicArray(T* items, int size): size(size) {
+        DynamicArray() : arr(nullptr), size(0), capacity(0) {}
+        DynamicArray(T* items, int size): size(size), capacity(size) {
             if (size < 0) {
                 throw std::logic_error("Trying to make an array with a negative size: " + std::to_string(size));
             } else if (size == 0) {
                 arr = nullptr;
             } else {
-                arr = new(std::nothrow) T[size];
-                if (!arr)
-                    throw std::runtime_error("Allocation during construction failed");
                 if (!items && size > 0)
                     throw std::runtime_error("Passing nullptr, assuming it is a non-void array");
-                for (int i = 0; i < size; ++i)
-                    arr[i] = items[i];
+                arr = Allocate(size, "construction");
+                try {
+                    std::uninitialized_copy_n(items, size, arr);
+                } catch (...) {
+                    Deallocate(arr);
+                    throw;
+                }
             }
         }
-        DynamicArray (int size): size(size) {
+        // Uses items in place instead of copying them, keeper keeps their memory alive. The first
+        // reallocation copies the items into storage of the array's own
+        DynamicArray(T* items, int size, std::shared_ptr<const void> keeper): arr(items), size(size), capacity(size), keeper(std::move(keeper)) {
+            static_assert(std::is_trivially_copyable<T>::value, "Only trivially copyable items can be borrowed");
+            if (size < 0)
+                throw std::logic_error("Trying to make an array with a negative size: " + std::to_string(size));
+            if (!items && size > 0)
+                throw std::runtime_error("Passing nullptr, assuming it is a non-void array");
+        }
+        DynamicArray (int size): size(size), capacity(size) {
             if (size < 0)
                 throw std::logic_error("Trying to make an array with a negative size: " + std::to_string(size));
             else if (size == 0) {
                 arr = nullptr;
             } else {
-                arr = new(std::nothrow) T[size];
-                if (!arr)
-                    throw std::runtime_error("Allocation during construction failed");
-            }
-        }
-        DynamicArray(const DynamicArray<T> &dynamicArray): size(dynamicArray.size) {
-            arr = new(std::nothrow) T[size];
-            if (!arr)
-                throw std::runtime_error("Allocation during construction failed");
-            for (int i = 0; i < size; ++i)
-                arr[i] = dynamicArray.arr[i];
-        }
-        T Get(int index) {
-            if (index >= size)
-                throw Lab::IndexOutOfRange("Went out of range, requesting " + std::to_string(index) + "-th element in array with length " + std::to_string(size));
-            if (index < 0) 
-                throw Lab::IndexOutOfRange("Went out of range, requesting element with a negative index");
+                arr = Allocate(size, "construction");
+                try {
+                    std::uninitialized_value_construct_n(arr, size);
+                } catch (...) {
+                    Deallocate(arr);
+                    throw;
+                }
+            }
+        }
+        DynamicArray(const DynamicArray &dynamicArray): size(dynamicArray.size), capacity(dynamicArray.size), growthFactor(dynamicArray.growthFactor) {
+            arr = Allocate(size, "construction");
+            try {
+                std::uninitialized_copy_n(dynamicArray.arr, size, arr);
+            } catch (...) {
+                Deallocate(arr);
+                throw;
+            }
+        }
+        DynamicArray(DynamicArray &&dynamicArray) noexcept: arr(dynamicArray.arr), size(dynamicArray.size), capacity(dynamicArray.capacity), growthFactor(dynamicArray.growthFactor), keeper(std::move(dynamicArray.keeper)) {
+            dynamicArray.arr = nullptr;
+            dynamicArray.size = 0;
+            dynamicArray.capacity = 0;
+        }
+        DynamicArray& operator=(const DynamicArray &dynamicArray) {
+            if (this != &dynamicArray) {
+                DynamicArray copy(dynamicArray);
+                Swap(copy);
+            }
+            return *this;
+        }
+        DynamicArray& operator=(DynamicArray &&dynamicArray) noexcept {
+            DynamicArray moved(std::move(dynamicArray));
+            Swap(moved);
+            return *this;
+        }
+        void Swap(DynamicArray &dynamicArray) noexcept {
+            std::swap(arr, dynamicArray.arr);
+            std::swap(size, dynamicArray.size);
+            std::swap(capacity, dynamicArray.capacity);
+            std::swap(growthFactor, dynamicArray.growthFactor);
+            std::swap(keeper, dynamicArray.keeper);
+        }
+        const T& Get(int index) const {
+            if constexpr (Check::enabled)
+                if (!Lab::InRange(index, size))
+                    Lab::ThrowIndexOutOfRange("Went out of range, requesting element with a negative index", "requesting", index, size);
+            return arr[index];
+        }
+        T& operator[](int index) {
+            if constexpr (Check::enabled)
+                if (!Lab::InRange(index, size))
+                    Lab::ThrowIndexOutOfRange("Went out of range, requesting element with a negative index", "requesting", index, size);
             return arr[index];
         }
+        const T& operator[](int index) const {
+            return Get(index);
+        }
         int GetSize() const {
             return size;
         }
+
+        using iterator = T*;
+        using const_iterator = const T*;
+
+        iterator begin() { return arr; }
+        iterator end() { return arr + size; }
+        const_iterator begin() const { return arr; }
+        const_iterator end() const { return arr + size; }
+        const_iterator cbegin() const { return arr; }
+        const_iterator cend() const { return arr + size; }
+        bool IsBorrowed() const {
+            return keeper != nullptr;
+        }
+        int GetCapacity() const {
+            return capacity;
+        }
+        double GetGrowthFactor() const {
+            return growthFactor;
+        }
+        void SetGrowthFactor(double factor) {
+            // A factor of 1 or less would degrade Append back to a copy per call
+            if (!(factor > 1.0))
+                throw std::logic_error("Growth factor must be greater than 1: " + std::to_string(factor));
+            growthFactor = factor;
+        }
         void Set(int index, T value) {
-            if (index < 0)
-                throw Lab::IndexOutOfRange("Went out of range, trying to set value to a negative index");
-            if (index >= size)
-                throw Lab::IndexOutOfRange("Went out of range, trying to set " + std::to_string(index) + "-th element in array with length " + std::to_string(size));
-            arr[index] = value;
+            if constexpr (Check::enabled)
+                if (!Lab::InRange(index, size))
+                    Lab::ThrowIndexOutOfRange("Went out of range, trying to set value to a negative index", "trying to set", index, size);
+            arr[index] = std::move(value);
+        }
+        template <typename... Args>
+        T& Emplace(Args&&... args) {
+            if (size == capacity) {
+                // Built before growing, args may refer to an element of this array
+                T item(std::forward<Args>(args)...);
+                Grow(size + 1);
+                ::new (static_cast<void*>(arr + size)) T(std::move(item));
+            } else {
+                ::new (static_cast<void*>(arr + size)) T(std::forward<Args>(args)...);
+            }
+            return arr[size++];
+        }
+        template <typename... Args>
+        T& EmplaceAt(int index, Args&&... args) {
+            if constexpr (Check::enabled)
+                if (!Lab::InRange(index, size + 1))
+                    Lab::ThrowIndexOutOfRange("Went out of range, trying to insert an element at a negative index", "trying to insert", index, size);
+            // Built before shifting, args may refer to an element of this array
+            T item(std::forward<Args>(args)...);
+            if (size == capacity)
+                Grow(size + 1);
+            if (index == size) {
+                ::new (static_cast<void*>(arr + size)) T(std::move(item));
+            } else {
+                // The last element moves into raw memory, the rest shift over live objects
+                ::new (static_cast<void*>(arr + size)) T(std::move(arr[size - 1]));
+                std::move_backward(arr + index, arr + size - 1, arr + size);
+                arr[index] = std::move(item);
+            }
+            ++size;
+            return arr[index];
+        }
+        // Inserts the items of [first, last) before index with at most one reallocation and one shift of
+        // the items after index. A range into this array is copied out first when the shift would clobber it
+        template <typename It>
+        void InsertRange(int index, It first, It last) {
+            static_assert(std::is_base_of<std::forward_iterator_tag, typename std::iterator_traits<It>::iterator_category>::value,
+                          "InsertRange counts the items first, it needs forward iterators");
+            if constexpr (Check::enabled)
+                if (!Lab::InRange(index, size + 1))
+                    Lab::ThrowIndexOutOfRange("Went out of range, trying to insert an element at a negative index", "trying to insert", index, size);
+            long long count = std::distance(first, last);
+            if (count == 0)
+                return;
+            if (size + count > std::numeric_limits<int>::max())
+                throw std::logic_error("Too many items for one array: " + std::to_string(size + count));
+            int n = static_cast<int>(count);
+            if (size + n > capacity) {
+                // One new buffer gets the items before index, the range and the items after it
+                int grown = static_cast<int>(std::min<double>(capacity * growthFactor, std::numeric_limits<int>::max()));
+                int newCapacity = std::max(size + n, grown);
+                T* ptr = Allocate(newCapacity, "insertion");
+                try {
+                    std::uninitialized_copy(first, last, ptr + index);
+                } catch (...) {
+                    Deallocate(ptr);
+                    throw;
+                }
+                try {
+                    Take(arr, index, ptr);
+                } catch (...) {
+                    std::destroy_n(ptr + index, n);
+                    Deallocate(ptr);
+                    throw;
+                }
+                try {
+                    Take(arr + index, size - index, ptr + index + n);
+                } catch (...) {
+                    std::destroy_n(ptr, index + n);
+                    Deallocate(ptr);
+                    throw;
+                }
+                if (keeper) {
+                    keeper.reset();
+                } else {
+                    std::destroy_n(arr, size);
+                    Deallocate(arr);
+                }
+                arr = ptr;
+                capacity = newCapacity;
+                size += n;
+                return;
+            }
+            if (Aliases(first, last)) {
+                // The shift below would overwrite the range before it is read
+                DynamicArray copy;
+                copy.Assign(first, last);
+                InsertRange(index, std::make_move_iterator(copy.begin()), std::make_move_iterator(copy.end()));
+                return;
+            }
+            T* pos = arr + index;
+            T* end = arr + size;
+            int after = size - index;
+            if (after > n) {
+                std::uninitialized_move(end - n, end, end);
+                size += n;
+                std::move_backward(pos, end - n, end);
+                std::copy(first, last, pos);
+            } else {
+                It mid = first;
+                std::advance(mid, after);
+                std::uninitialized_copy(mid, last, end);
+                try {
+                    std::uninitialized_move(pos, end, pos + n);
+                } catch (...) {
+                    std::destroy(end, pos + n);
+                    throw;
+                }
+                size += n;
+                std::copy(first, mid, pos);
+            }
         }
+        template <typename It>
+        void AppendRange(It first, It last) {
+            InsertRange(size, first, last);
+        }
+        // Replaces the items with [first, last). Items already here are assigned over, the array
+        // reallocates only when the range doesn't fit
+        template <typename It>
+        void Assign(It first, It last) {
+            static_assert(std::is_base_of<std::forward_iterator_tag, typename std::iterator_traits<It>::iterator_category>::value,
+                          "Assign counts the items first, it needs forward iterators");
+            long long count = std::distance(first, last);
+            if (count > std::numeric_limits<int>::max())
+                throw std::logic_error("Too many items for one array: " + std::to_string(count));
+            int n = static_cast<int>(count);
+            if (n > capacity || keeper) {
+                DynamicArray fresh;
+                fresh.growthFactor = growthFactor;
+                fresh.arr = Allocate(n, "assignment");
+                try {
+                    std::uninitialized_copy(first, last, fresh.arr);
+                } catch (...) {
+                    Deallocate(fresh.arr);
+                    fresh.arr = nullptr;
+                    throw;
+                }
+                fresh.size = fresh.capacity = n;
+                Swap(fresh);
+                return;
+            }
+            if (n <= size) {
+                std::copy(first, last, arr);
+                std::destroy(arr + n, arr + size);
+            } else {
+                It mid = first;
+                std::advance(mid, size);
+                std::copy(first, mid, arr);
+                std::uninitialized_copy(mid, last, arr + size);
+            }
+            size = n;
+        }
+        void Reserve(int newCapacity) {
+            if (newCapacity < 0)
+                throw std::logic_error("Trying to reserve a negative capacity: " + std::to_string(newCapacity));
+            if (newCapacity > capacity)
+                Reallocate(newCapacity);
+        }
+        void ShrinkToFit() {
+            if (capacity == size)
+                return;
+            if (size == 0) {
+                if (keeper)
+                    keeper.reset();
+                else
+                    Deallocate(arr);
+                arr = nullptr;
+                capacity = 0;
+                return;
+            }
+            Reallocate(size);
+        }
+        // Grows geometrically, so a sequence of Resize(size + 1) calls is amortized O(1)
         void Resize(int newSize) {
             if (newSize == size)
                 return;
             if (newSize < 0)
                 throw std::logic_error("Trying to resize the array to a negative size: " + std::to_string(newSize));
-            T* ptr;
-            ptr = new (std::nothrow) T[newSize];
-            if (!ptr)
-                throw std::runtime_error("Allocation during Resize failed");
-            for (int i = 0; i < std::min(newSize, size); ++i)
-                ptr[i] = arr[i];
-            if (arr)
-                delete []arr;
-            arr = ptr;
+            if (newSize > capacity)
+                Grow(newSize);
+            if (newSize < size)
+                std::destroy(arr + newSize, arr + size);
+            else
+                std::uninitialized_value_construct(arr + size, arr + newSize);
             size = newSize;
         }
         ~DynamicArray () {
-            delete []arr;
+            if (keeper)
+                return;
+            std::destroy_n(arr, size);
+            Deallocate(arr);
         }
         friend std::ostream& operator<<(std::ostream &out, const DynamicArray &da) {
             if (da.size == 0) {
@@ -1,3 +1,9 @@
+#if defined(__GNUC__) || defined(__clang__)
+#define LAB_COLD __attribute__((cold, noinline))
+#else
+#define LAB_COLD
+#endif
+
 namespace Lab {
     class IndexOutOfRange: public std::logic_error {
     public:
@@ -11,4 +17,42 @@ namespace Lab {
     public:
         UpperAndLower (const std::string &s): std::logic_error(s) {}
     };
+    class Singular: public std::logic_error {
+    public:
+        Singular (const std::string &s): std::logic_error(s) {}
+    };
+
+    // Error paths live out of line: a checked access inlines to a compare and a branch to here
+    [[noreturn]] LAB_COLD inline void ThrowIndexOutOfRange(const char *negative, const char *action, long long index, long long size) {
+        if (index < 0)
+            throw IndexOutOfRange(negative);
+        throw IndexOutOfRange(std::string("Went out of range, ") + action + " " + std::to_string(index) + "-th element in array with length " + std::to_string(size));
+    }
+    [[noreturn]] LAB_COLD inline void ThrowIndexOutOfRange(const char *what) {
+        throw IndexOutOfRange(what);
+    }
+    [[noreturn]] LAB_COLD inline void ThrowLogicError(const char *what) {
+        throw std::logic_error(what);
+    }
+
+    // Bounds-check policies for the containers. Checked always validates indices, DebugChecked only
+    // in builds without NDEBUG, Unchecked never: out-of-range access is then undefined behaviour
+    struct Checked {
+        static constexpr bool enabled = true;
+    };
+    struct DebugChecked {
+#ifdef NDEBUG
+        static constexpr bool enabled = false;
+#else
+        static constexpr bool enabled = true;
+#endif
+    };
+    struct Unchecked {
+        static constexpr bool enabled = false;
+    };
+
+    // index in [0, size) with one unsigned comparison
+    inline bool InRange(int index, int size) {
+        return static_cast<unsigned>(index) < static_cast<unsigned>(size);
+    }
 }
\ No newline at end of file
@@ -1,119 +1,224 @@
 namespace Lab {
-    template <typename T> 
+    template <typename T>
+    struct ListNode {
+        T item;
+        ListNode* next = nullptr;
+        template <typename... Args>
+        explicit ListNode(ListNode* next, Args&&... args) : item(std::forward<Args>(args)...), next(next) {}
+    };
+
+    template <typename T, bool Const>
+    class ListIterator {
+        using Node = typename std::conditional<Const, const ListNode<T>, ListNode<T>>::type;
+        Node* node = nullptr;
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = typename std::conditional<Const, const T*, T*>::type;
+        using reference = typename std::conditional<Const, const T&, T&>::type;
+
+        ListIterator() = default;
+        explicit ListIterator(Node* node) : node(node) {}
+        template <bool C = Const, typename = typename std::enable_if<C>::type>
+        ListIterator(const ListIterator<T, false>& it) : node(it.GetNode()) {}
+
+        Node* GetNode() const { return node; }
+        reference operator*() const { return node->item; }
+        pointer operator->() const { return &(node->item); }
+        ListIterator& operator++() {
+            node = node->next;
+            return *this;
+        }
+        ListIterator operator++(int) {
+            ListIterator prev = *this;
+            node = node->next;
+            return prev;
+        }
+        bool operator==(const ListIterator& it) const { return node == it.node; }
+        bool operator!=(const ListIterator& it) const { return node != it.node; }
+    };
+
+    template <typename T, typename Allocator = Lab::PoolAllocator<T>, typename Check = Lab::Checked>
     class LinkedList {
-        struct ListNode {
-            T item;
-            ListNode* next = nullptr;
-        };
+        using ListNode = Lab::ListNode<T>;
+        using NodeAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<ListNode>;
+        using NodeTraits = std::allocator_traits<NodeAllocator>;
+
+        NodeAllocator alloc;
         ListNode* head = nullptr;
+        ListNode* tail = nullptr;
         int size = 0;
+
+        template <typename... Args>
+        ListNode* NewNode(ListNode* next, Args&&... args) {
+            ListNode* node = NodeTraits::allocate(alloc, 1);
+            try {
+                NodeTraits::construct(alloc, node, next, std::forward<Args>(args)...);
+            } catch (...) {
+                NodeTraits::deallocate(alloc, node, 1);
+                throw;
+            }
+            return node;
+        }
+
+        void DeleteNode(ListNode* node) {
+            NodeTraits::destroy(alloc, node);
+            NodeTraits::deallocate(alloc, node, 1);
+        }
+
+        ListNode* NodeAt(int index) const {
+            ListNode* elem = this->head;
+            for (int i = 0; i < index; ++i)
+                elem = elem->next;
+            return elem;
+        }
+
+        ListNode** SlotAt(int index) {
+            ListNode** elem = &(this->head);
+            for (int i = 0; i < index; ++i)
+                elem = &((*elem)->next);
+            return elem;
+        }
+
+        void PushBack(ListNode* node) {
+            if (this->tail)
+                this->tail->next = node;
+            else
+                this->head = node;
+            this->tail = node;
+            ++(this->size);
+        }
     public:
         LinkedList() : size(0) {}
+        explicit LinkedList(const Allocator& allocator) : alloc(allocator), size(0) {}
         LinkedList(T* items, int size) : LinkedList() {
             if (size < 0) 
                 throw std::logic_error("Trying to make a list with a negative size: " + std::to_string(size));
             if (!items && size > 0)
                 throw std::runtime_error("Passing nullptr, assuming it is a non-void array");
-            ListNode** elem = &(this->head);
-            for (int i = 0; i < size; ++i) {
-                *elem = new ListNode;
-                (*elem)->item = items[i];
-                elem = &((*elem)->next);
-            }
-            this->size = size;
+            for (int i = 0; i < size; ++i)
+                Emplace(items[i]);
         }
 
         LinkedList(int size) : LinkedList() {
             if (size < 0) 
                 throw std::logic_error("Trying to make a list with a negative size: " + std::to_string(size));
 
-            ListNode** elem = &(this->head);
-            for (int i = 0; i < size; ++i) {
-                *elem = new ListNode;
-                (*elem)->item = T();
-                elem = &((*elem)->next);
-            }
-            this->size = size;
+            for (int i = 0; i < size; ++i)
+                Emplace();
         }
 
-        LinkedList(const LinkedList<T>& list) {
-            ListNode* elem = list.head;
-            ListNode** newelem = &(this->head);
+        LinkedList(const LinkedList& list) : LinkedList(NodeTraits::select_on_container_copy_construction(list.alloc)) {
+            for (ListNode* elem = list.head; elem != nullptr; elem = elem->next)
+                Emplace(elem->item);
+        }
+
+        // The allocator is copied, not moved: the emptied list keeps a usable one
+        LinkedList(LinkedList&& list) noexcept : alloc(list.alloc), head(list.head), tail(list.tail), size(list.size) {
+            list.head = nullptr;
+            list.tail = nullptr;
+            list.size = 0;
+        }
 
-            for (int i = 0; i < list.size; i++, elem = elem->next) {
-                *newelem = new ListNode;
-                (*newelem)->item = elem->item;
-                newelem = &((*newelem)->next);
+        LinkedList& operator=(const LinkedList& list) {
+            if (this != &list) {
+                LinkedList copy(list);
+                Swap(copy);
             }
-            this->size = list.size;
+            return *this;
+        }
+
+        LinkedList& operator=(LinkedList&& list) noexcept {
+            LinkedList moved(std::move(list));
+            Swap(moved);
+            return *this;
+        }
+
+        void Swap(LinkedList& list) noexcept {
+            std::swap(this->alloc, list.alloc);
+            std::swap(this->head, list.head);
+            std::swap(this->tail, list.tail);
+            std::swap(this->size, list.size);
         }
 
         virtual ~LinkedList() {
+            // Pool chunks are released all at once with the last allocator, nothing to do per node
+            if (std::is_trivially_destructible<T>::value && Lab::CanReleaseInBulk(this->alloc))
+                return;
             ListNode* elem = this->head;
             ListNode* next;
             while (elem != nullptr) {
                 next = elem->next;
-                delete elem;
+                DeleteNode(elem);
                 elem = next;
             }
             this->size = 0;
         }
 
-        T GetFirst() const {
-            if (this->size == 0) 
-                throw Lab::IndexOutOfRange("Trying to get the first element of an empty list");
-            return this->head->item;
+        Allocator GetAllocator() const {
+            return Allocator(alloc);
         }
 
-        T GetLast() const {
-            if (this->size == 0) 
-                throw Lab::IndexOutOfRange("Trying to get the last element of an empty list");
-            ListNode* elem = this->head;
-            while (elem->next != nullptr) 
-                elem = elem->next;
-            return elem->item;
+        using iterator = Lab::ListIterator<T, false>;
+        using const_iterator = Lab::ListIterator<T, true>;
+
+        iterator begin() { return iterator(this->head); }
+        iterator end() { return iterator(); }
+        const_iterator begin() const { return const_iterator(this->head); }
+        const_iterator end() const { return const_iterator(); }
+        const_iterator cbegin() const { return begin(); }
+        const_iterator cend() const { return end(); }
+
+        const T& GetFirst() const {
+            if constexpr (Check::enabled)
+                if (this->size == 0)
+                    Lab::ThrowIndexOutOfRange("Trying to get the first element of an empty list");
+            return this->head->item;
         }
 
-        T Get(int index) const {
-            if (index < 0) 
-                throw Lab::IndexOutOfRange("Trying to get an element with a negative index");
-            if (index >= this->size)
-                throw Lab::IndexOutOfRange("Went out of range, trying to get " + std::to_string(index) + "-th element in array with length " + std::to_string(size));
+        const T& GetLast() const {
+            if constexpr (Check::enabled)
+                if (this->size == 0)
+                    Lab::ThrowIndexOutOfRange("Trying to get the last element of an empty list");
+            return this->tail->item;
+        }
 
-            ListNode* elem = this->head;
-            for (int i = 0; i < index; ++i)
-                elem = elem->next;
+        const T& Get(int index) const {
+            if constexpr (Check::enabled)
+                if (!Lab::InRange(index, this->size))
+                    Lab::ThrowIndexOutOfRange("Trying to get an element with a negative index", "trying to get", index, this->size);
+            return NodeAt(index)->item;
+        }
 
-            return elem->item;
+        // Walks index nodes like Get, but hands out the item itself
+        T& operator[](int index) {
+            if constexpr (Check::enabled)
+                if (!Lab::InRange(index, this->size))
+                    Lab::ThrowIndexOutOfRange("Trying to get an element with a negative index", "trying to get", index, this->size);
+            return NodeAt(index)->item;
+        }
+        const T& operator[](int index) const {
+            return Get(index);
         }
 
         void Set(const T& item, int index) {
-            if (index < 0) 
-                throw Lab::IndexOutOfRange("Trying to set an element with a negative index");
-            if (index >= this->size)
-                throw Lab::IndexOutOfRange("Went out of range, trying to set " + std::to_string(index) + "-th element in array with length " + std::to_string(size));
-
-            ListNode* elem = this->head;
-            for (int i = 0; i < index; ++i)
-                elem = elem->next;
-            elem->item = item;
+            if constexpr (Check::enabled)
+                if (!Lab::InRange(index, this->size))
+                    Lab::ThrowIndexOutOfRange("Trying to set an element with a negative index", "trying to set", index, this->size);
+            NodeAt(index)->item = item;
         }
 
-        LinkedList<T>* GetSubList(int start, int end) const { //end is excluding
+        LinkedList* GetSubList(int start, int end) const { //end is excluding
             if (start < 0 || start >= this->size || end < 0 || end > this->size || start > end) 
                 throw Lab::IndexOutOfRange("Trying to get sublist with the wrong bounds");
 
-            LinkedList<T>* newList = new LinkedList<T>();
+            LinkedList* newList = new LinkedList();
             ListNode* elem = this->head;
-            ListNode** newelem = &newList->head;
 
             for (int i = 0; i < end; ++i, elem = elem->next) 
-                if (i >= start) {
-                    *newelem = new ListNode;
-                    (*newelem)->item = elem->item;
-                    newelem = &((*newelem)->next);
-                }
-            newList->size = end - start;
+                if (i >= start)
+                    newList->Emplace(elem->item);
             return newList;
         }
 
@@ -122,68 +227,221 @@ namespace Lab {
         }
 
         void Append(const T& item) {
-            ListNode** elem = &(this->head);
+            Emplace(item);
+        }
 
-            while (*elem != nullptr) 
-                elem = &((*elem)->next);
-            (*elem) = new ListNode;
-            (*elem)->item = item;
+        void Append(T&& item) {
+            Emplace(std::move(item));
+        }
 
-            ++(this->size);
+        template <typename... Args>
+        T& Emplace(Args&&... args) {
+            PushBack(NewNode(nullptr, std::forward<Args>(args)...));
+            return this->tail->item;
         }
 
         void Prepend(const T& item) {
-            ListNode* elem = new ListNode{item, this->head};
-            this->head = elem;
-            ++(this->size);
+            EmplaceAt(0, item);
+        }
+
+        void Prepend(T&& item) {
+            EmplaceAt(0, std::move(item));
         }
 
         void InsertAt(const T& item, int index) {
-            if (index < 0) 
-                throw Lab::IndexOutOfRange("Trying to set an element with a negative index");
-            if (index > this->size)
-                throw Lab::IndexOutOfRange("Went out of range, trying to set " + std::to_string(index) + "-th element in array with length " + std::to_string(size));
-
-            if (!index) {
-                ListNode *newhead = new ListNode;
-                newhead->next = this->head;
-                newhead->item = item;
-                this->head = newhead;
-            } else {
-                ListNode *elem = this->head;
-                for (int i = 0; i < index - 1; ++i)
-                    elem = elem->next;
-                ListNode *prevnext = elem->next;
-                elem->next = new ListNode;
-                elem->next->item = item;
-                elem->next->next = prevnext;
-            }
-        
+            EmplaceAt(index, item);
+        }
+
+        void InsertAt(T&& item, int index) {
+            EmplaceAt(index, std::move(item));
+        }
+
+        template <typename... Args>
+        T& EmplaceAt(int index, Args&&... args) {
+            if constexpr (Check::enabled)
+                if (!Lab::InRange(index, this->size + 1))
+                    Lab::ThrowIndexOutOfRange("Trying to set an element with a negative index", "trying to set", index, this->size);
+
+            if (index == this->size)
+                return Emplace(std::forward<Args>(args)...);
+            ListNode** elem = SlotAt(index);
+            *elem = NewNode(*elem, std::forward<Args>(args)...);
             ++(this->size);
+            return (*elem)->item;
         }
 
-        LinkedList<T>* Concat(const LinkedList<T>& list) const {
-            ListNode* first = this->head;
-            ListNode* second = list.head;
+        // Builds the nodes of [first, last) off to the side, then links them in before index with a
+        // single walk to it. The list is untouched if an item throws, and the range may come from it
+        template <typename It>
+        void InsertRange(int index, It first, It last) {
+            if constexpr (Check::enabled)
+                if (!Lab::InRange(index, this->size + 1))
+                    Lab::ThrowIndexOutOfRange("Trying to set an element with a negative index", "trying to set", index, this->size);
+            ListNode* chainHead = nullptr;
+            ListNode* chainTail = nullptr;
+            int count = 0;
+            try {
+                for (; first != last; ++first, ++count) {
+                    ListNode* node = NewNode(nullptr, *first);
+                    if (chainTail)
+                        chainTail->next = node;
+                    else
+                        chainHead = node;
+                    chainTail = node;
+                }
+            } catch (...) {
+                while (chainHead) {
+                    ListNode* next = chainHead->next;
+                    DeleteNode(chainHead);
+                    chainHead = next;
+                }
+                throw;
+            }
+            if (count == 0)
+                return;
+            ListNode** slot = index == this->size ? (this->tail ? &(this->tail->next) : &(this->head)) : SlotAt(index);
+            chainTail->next = *slot;
+            *slot = chainHead;
+            if (index == this->size)
+                this->tail = chainTail;
+            this->size += count;
+        }
+        template <typename It>
+        void AppendRange(It first, It last) {
+            InsertRange(this->size, first, last);
+        }
+        // Replaces the items with [first, last), reusing the nodes already here
+        template <typename It>
+        void Assign(It first, It last) {
+            ListNode** slot = &(this->head);
+            ListNode* lastKept = nullptr;
+            int kept = 0;
+            for (; *slot && first != last; ++first, ++kept) {
+                (*slot)->item = *first;
+                lastKept = *slot;
+                slot = &((*slot)->next);
+            }
+            ListNode* rest = *slot;
+            *slot = nullptr;
+            this->tail = lastKept;
+            this->size = kept;
+            while (rest) {
+                ListNode* next = rest->next;
+                DeleteNode(rest);
+                rest = next;
+            }
+            AppendRange(first, last);
+        }
 
-            LinkedList<T>* newList = new LinkedList<T>();
-            ListNode** elem = &(newList->head);
-            while (first != nullptr) {
-                *elem = new ListNode;
-                (*elem)->item = first->item;
-                (*elem)->next = first->next;
-                first = first->next;
-                elem = &((*elem)->next);
+        // Moves all nodes of list to the end of this one without copying, O(1) when both
+        // lists share an allocator. Otherwise nodes can't change owners and items are moved one by one
+        void Splice(LinkedList&& list) {
+            if (&list == this || list.size == 0)
+                return;
+            if (!(this->alloc == list.alloc)) {
+                for (ListNode* elem = list.head; elem != nullptr; elem = elem->next)
+                    Emplace(std::move(elem->item));
+                list = LinkedList(list.GetAllocator());
+                return;
             }
-            while (second != nullptr) {
-                *elem = new ListNode;
-                (*elem)->item = second->item;
-                (*elem)->next = second->next;
-                second = second->next;
-                elem = &((*elem)->next);
+            if (this->tail)
+                this->tail->next = list.head;
+            else
+                this->head = list.head;
+            this->tail = list.tail;
+            this->size += list.size;
+            list.head = list.tail = nullptr;
+            list.size = 0;
+        }
+
+        // Stable sort that relinks the nodes, items are never copied or moved. The node pointers are
+        // sorted in an array, a merge sort walking the list itself is a few times slower on long lists
+        template <typename Compare>
+        void Sort(Compare comp) {
+            if (this->size < 2)
+                return;
+            DynamicArray<ListNode*> nodes;
+            nodes.Reserve(this->size);
+            for (ListNode* elem = this->head; elem != nullptr; elem = elem->next)
+                nodes.Emplace(elem);
+            std::stable_sort(nodes.begin(), nodes.end(), [&comp](const ListNode* a, const ListNode* b) { return comp(a->item, b->item); });
+            ListNode** slot = &(this->head);
+            for (ListNode* node : nodes) {
+                *slot = node;
+                slot = &(node->next);
+            }
+            *slot = nullptr;
+            this->tail = nodes.cend()[-1];
+        }
+
+        // Merges the sorted list into this sorted one by relinking, items of this list go first among
+        // equal ones. Lists with different allocators can't trade nodes, the items are moved instead.
+        // If comp throws, this list holds every node of both, not in sorted order
+        template <typename Compare>
+        void Merge(LinkedList&& list, Compare comp) {
+            if (&list == this || list.size == 0)
+                return;
+            if (!(this->alloc == list.alloc)) {
+                Splice(std::move(list));
+                Sort(comp);
+                return;
+            }
+            if (this->size == 0) {
+                Splice(std::move(list));
+                return;
             }
+            // The chain that runs out last keeps its tail at the end
+            ListNode* tail = comp(list.tail->item, this->tail->item) ? this->tail : list.tail;
+            ListNode* a = this->head;
+            ListNode* b = list.head;
+            ListNode* aTail = this->tail;
+            ListNode* bTail = list.tail;
+            this->size += list.size;
+            list.head = list.tail = nullptr;
+            list.size = 0;
+            ListNode** last = &(this->head);
+            try {
+                while (a && b) {
+                    ListNode*& smaller = comp(b->item, a->item) ? b : a;
+                    *last = smaller;
+                    last = &(smaller->next);
+                    smaller = smaller->next;
+                }
+            } catch (...) {
+                // Keeps every node: the merged part, then the rest of this chain, then the rest of the other
+                *last = a;
+                aTail->next = b;
+                this->tail = bTail;
+                throw;
+            }
+            *last = a ? a : b;
+            this->tail = tail;
+        }
 
-            newList->size = this->size + list.size;
+        // Moves the nodes from index on into a new list with the same allocator, O(index)
+        LinkedList SplitOff(int index) {
+            if constexpr (Check::enabled)
+                if (!Lab::InRange(index, this->size + 1))
+                    Lab::ThrowIndexOutOfRange("Trying to split a list at a negative index", "trying to split at", index, this->size);
+            LinkedList rest(GetAllocator());
+            if (index == this->size)
+                return rest;
+            ListNode* last = index == 0 ? nullptr : NodeAt(index - 1);
+            rest.head = last ? last->next : this->head;
+            rest.tail = this->tail;
+            rest.size = this->size - index;
+            (last ? last->next : this->head) = nullptr;
+            this->tail = last;
+            this->size = index;
+            return rest;
+        }
+
+        LinkedList* Concat(const LinkedList& list) const {
+            LinkedList* newList = new LinkedList(*this);
+            // Bounded by the original length, so concatenating a list with itself terminates
+            ListNode* elem = list.head;
+            for (int i = 0, n = list.size; i < n; ++i, elem = elem->next)
+                newList->Emplace(elem->item);
             return newList;
         }
         friend std::ostream& operator<<(std::ostream &out, const LinkedList &ll) {
@@ -1,12 +1,36 @@
 #include <iostream>
 #include <new>
+#include <memory>
+#include <cstddef>
 #include <cmath>
 #include <iomanip>
+#include <limits>
+#include <algorithm>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <exception>
+#include <fstream>
+#include <cstdint>
+#include <cstring>
+#include <cerrno>
 #include "exceptions.hpp"
 #include "dynamic_array.hpp"
+#include "node_pool.hpp"
 #include "linked_list.hpp"
 #include "sequence.hpp"
+#include "rope_sequence.hpp"
+#include "thread_pool.hpp"
+#include "algorithms.hpp"
+#include "simd_kernels.hpp"
+#include "triangle_storage.hpp"
+#include "triangle_expression.hpp"
 #include "triangle_matrix.hpp"
+#include "serialization.hpp"
 #include "interface.hpp"
 
 
@@ -86,6 +110,21 @@ void testDynamicArray () {
     } catch (Lab::IndexOutOfRange &e) {
         std::cout << e.what() << std::endl;
     }
+
+    std::cout << std::endl << "Borrowed storage:" << std::endl;
+
+    // An array read straight from a mapped file doesn't own its items, growing copies them out and
+    // shrinking an empty one only lets go of the file
+    Lab::Save(Lab::ArraySequence <int>(ptr, 10), "dynamic_array.bin");
+    Lab::BinaryHeader header;
+    Lab::DynamicArray <int> mapped = Lab::Binary::Map<int>("dynamic_array.bin", "LABS", header);
+    Lab::DynamicArray <int> grown = Lab::Binary::Map<int>("dynamic_array.bin", "LABS", header);
+    grown.Reserve(20);
+    std::cout << "Mapped, then Reserve(20): " << grown << std::endl;
+    mapped.Resize(0);
+    mapped.ShrinkToFit();
+    std::cout << "Mapped, then Resize(0) and ShrinkToFit(): size " << mapped.GetSize() << std::endl;
+    std::remove("dynamic_array.bin");
 }
 void testLinkedList () {
     // Example of work of Dynamic Array
@@ -227,6 +266,18 @@ void testArraySequence() {
     std::cout << "*y = das.Concat(*x): ";
     Lab::ArraySequence <int> *y = das.Concat(*x);
     y->Print();
+
+    // Ranges that point into the sequence itself, with capacity to spare so nothing reallocates
+    Lab::ArraySequence <int> self;
+    self.Reserve(40);
+    for (int i = 0; i < 10; ++i)
+        self.Append(i);
+    std::cout << "self.InsertRange(0, self.View(2, 5)): ";
+    self.InsertRange(0, self.View(2, 5));
+    self.Print();
+    std::cout << "self.InsertRange(1, self): ";
+    self.InsertRange(1, self);
+    self.Print();
 }
 void testTrMat() {
     Lab::Triangle_Matrix <int> tm(10, true);
@@ -252,6 +303,28 @@ void testTrMat() {
     std::cout << "tm.Sum(&neotm): " <<std::endl;
     neotm.Set(3, 1, 5);
     tm.Sum(&neotm)->Print();
+    std::cout << "(tm - neotm) * 2: " <<std::endl;
+    Lab::Triangle_Matrix <int> twice = (tm - neotm) * 2;
+    twice.Print();
+    std::cout << "tm.Multiply(&neotm): " <<std::endl;
+    Lab::Triangle_Matrix <int> *product = tm.Multiply(&neotm);
+    product->Print();
+    delete product;
+
+    Lab::Triangle_Matrix <double> lower(3, false);
+    lower.Fill(1);
+    lower.Set(2, 1, 1);
+    lower.Set(4, 2, 2);
+    double b[] = {1, 3, 7};
+    Lab::ArraySequence <double> rhs(b, 3);
+    Lab::ArraySequence <double> *x = lower.Solve(rhs);
+    std::cout << "lower.Solve(1 3 7): ";
+    x->Print();
+    std::cout << "lower.Multiply(x): ";
+    Lab::ArraySequence <double> *y = lower.Multiply(*x);
+    y->Print();
+    delete x;
+    delete y;
 }
 
 int main () {
@@ -0,0 +1,145 @@
+namespace Lab {
+    // Hands out fixed-size blocks carved from large chunks and keeps freed blocks in a free list.
+    // The block size is fixed by the first single-object request, anything else goes to operator new.
+    class NodeArena {
+        struct FreeBlock {
+            FreeBlock* next;
+        };
+        struct Chunk {
+            Chunk* next;
+        };
+        static constexpr std::size_t headerSize = (sizeof(Chunk) + alignof(std::max_align_t) - 1) / alignof(std::max_align_t) * alignof(std::max_align_t);
+        static constexpr std::size_t firstChunkBlocks = 32;
+        static constexpr std::size_t maxChunkBlocks = 65536;
+
+        std::size_t blockSize = 0;
+        std::size_t chunkBlocks = firstChunkBlocks;
+        FreeBlock* freeList = nullptr;
+        Chunk* chunks = nullptr;
+        char* cursor = nullptr;
+        char* chunkEnd = nullptr;
+
+        void NewChunk() {
+            void* raw = ::operator new(headerSize + blockSize * chunkBlocks);
+            Chunk* chunk = static_cast<Chunk*>(raw);
+            chunk->next = chunks;
+            chunks = chunk;
+            cursor = static_cast<char*>(raw) + headerSize;
+            chunkEnd = cursor + blockSize * chunkBlocks;
+            chunkBlocks = std::min(chunkBlocks * 2, maxChunkBlocks);
+        }
+    public:
+        NodeArena() = default;
+        NodeArena(const NodeArena&) = delete;
+        NodeArena& operator=(const NodeArena&) = delete;
+        ~NodeArena() {
+            while (chunks) {
+                Chunk* next = chunks->next;
+                ::operator delete(chunks);
+                chunks = next;
+            }
+        }
+
+        bool Serves(std::size_t bytes, std::size_t align) {
+            if (align > alignof(std::max_align_t))
+                return false;
+            std::size_t size = std::max(bytes, sizeof(FreeBlock));
+            align = std::max(align, alignof(FreeBlock));
+            size = (size + align - 1) / align * align;
+            if (blockSize == 0)
+                blockSize = size;
+            return size == blockSize;
+        }
+
+        void* Allocate() {
+            if (freeList) {
+                FreeBlock* block = freeList;
+                freeList = block->next;
+                return block;
+            }
+            if (cursor == chunkEnd)
+                NewChunk();
+            void* block = cursor;
+            cursor += blockSize;
+            return block;
+        }
+
+        void Deallocate(void* ptr) {
+            FreeBlock* block = static_cast<FreeBlock*>(ptr);
+            block->next = freeList;
+            freeList = block;
+        }
+    };
+
+    // Allocator over a NodeArena. Copies and rebinds share the arena, so every node of a list
+    // comes from the same chunks and all of them are returned when the last owner goes away.
+    // The arena has no lock: containers that share it through copies of one allocator (split
+    // lists, moved-from lists, GetAllocator) must not allocate or free from different threads at once.
+    template <typename T>
+    class PoolAllocator {
+        std::shared_ptr<NodeArena> arena;
+
+        template <typename U>
+        friend class PoolAllocator;
+    public:
+        using value_type = T;
+        using propagate_on_container_copy_assignment = std::false_type;
+        using propagate_on_container_move_assignment = std::true_type;
+        using propagate_on_container_swap = std::true_type;
+        using is_always_equal = std::false_type;
+        // Node memory is reclaimed with the arena, a container holding its last owner may skip
+        // freeing trivial nodes one by one (see CanReleaseInBulk)
+        using releases_in_bulk = std::true_type;
+
+        PoolAllocator() : arena(std::make_shared<NodeArena>()) {}
+        PoolAllocator(const PoolAllocator&) = default;
+        template <typename U>
+        PoolAllocator(const PoolAllocator<U>& other) : arena(other.arena) {}
+
+        T* allocate(std::size_t n) {
+            if (n == 1 && arena->Serves(sizeof(T), alignof(T)))
+                return static_cast<T*>(arena->Allocate());
+            return std::allocator<T>().allocate(n);
+        }
+
+        void deallocate(T* ptr, std::size_t n) {
+            if (n == 1 && arena->Serves(sizeof(T), alignof(T)))
+                arena->Deallocate(ptr);
+            else
+                std::allocator<T>().deallocate(ptr, n);
+        }
+
+        // A copied container starts its own pool instead of sharing the source's chunks
+        PoolAllocator select_on_container_copy_construction() const {
+            return PoolAllocator();
+        }
+        // No other allocator shares the arena, it goes away with this one
+        bool IsLastOwner() const {
+            return arena.use_count() == 1;
+        }
+
+        template <typename U>
+        bool operator==(const PoolAllocator<U>& other) const {
+            return arena == other.arena;
+        }
+        template <typename U>
+        bool operator!=(const PoolAllocator<U>& other) const {
+            return arena != other.arena;
+        }
+    };
+
+    template <typename Allocator, typename = void>
+    struct ReleasesInBulk : std::false_type {};
+    template <typename Allocator>
+    struct ReleasesInBulk<Allocator, std::void_t<typename Allocator::releases_in_bulk>> : Allocator::releases_in_bulk {};
+
+    // True when destroying alloc releases every block it handed out, so the nodes need no freeing.
+    // Only the last owner of a shared pool can say so, otherwise freed nodes must reach its free list
+    template <typename Allocator>
+    bool CanReleaseInBulk(const Allocator& alloc) {
+        if constexpr (ReleasesInBulk<Allocator>::value)
+            return alloc.IsLastOwner();
+        else
+            return false;
+    }
+}
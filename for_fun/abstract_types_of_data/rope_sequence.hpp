@@ -0,0 +1,366 @@
+namespace Lab {
+    // Sequence kept as an AVL tree whose leaves are chunks of up to Chunk items. Get, Set and InsertAt
+    // walk one root-to-leaf path, Concat and GetSubSequence join and split trees in O(log n) and share
+    // every untouched subtree with their inputs. Shared nodes are copied on the first write through them
+    template <typename T, int Chunk = 64>
+    class RopeSequence final : public Sequence<T>, public StaticSequence<RopeSequence<T, Chunk>, T> {
+        static_assert(Chunk > 1, "A chunk must hold at least two items");
+
+        struct Node;
+        using NodePtr = std::shared_ptr<Node>;
+
+        // A leaf holds items and no children, an inner node holds two children and no items
+        struct Node {
+            NodePtr left, right;
+            DynamicArray<T> items;
+            int size = 0;
+            int height = 1;
+
+            bool IsLeaf() const {
+                return !left;
+            }
+        };
+
+        NodePtr root;
+
+        static int Size(const NodePtr& node) {
+            return node ? node->size : 0;
+        }
+        static int Height(const NodePtr& node) {
+            return node ? node->height : 0;
+        }
+        static NodePtr MakeLeaf(DynamicArray<T>&& items) {
+            NodePtr leaf = std::make_shared<Node>();
+            leaf->size = items.GetSize();
+            leaf->items = std::move(items);
+            return leaf;
+        }
+        static NodePtr MakeLeaf(const T* items, int count, const T* more = nullptr, int moreCount = 0) {
+            DynamicArray<T> copy;
+            copy.Reserve(count + moreCount);
+            for (int i = 0; i < count; ++i)
+                copy.Emplace(items[i]);
+            for (int i = 0; i < moreCount; ++i)
+                copy.Emplace(more[i]);
+            return MakeLeaf(std::move(copy));
+        }
+        static NodePtr MakeNode(NodePtr left, NodePtr right) {
+            NodePtr node = std::make_shared<Node>();
+            node->size = left->size + right->size;
+            node->height = std::max(left->height, right->height) + 1;
+            node->left = std::move(left);
+            node->right = std::move(right);
+            return node;
+        }
+        // Node over left and right after at most one single or double rotation, enough when their
+        // heights differ by no more than two
+        static NodePtr Balance(NodePtr left, NodePtr right) {
+            if (left->height > right->height + 1) {
+                if (Height(left->left) >= Height(left->right))
+                    return MakeNode(left->left, MakeNode(left->right, std::move(right)));
+                return MakeNode(MakeNode(left->left, left->right->left), MakeNode(left->right->right, std::move(right)));
+            }
+            if (right->height > left->height + 1) {
+                if (Height(right->right) >= Height(right->left))
+                    return MakeNode(MakeNode(std::move(left), right->left), right->right);
+                return MakeNode(MakeNode(std::move(left), right->left->left), MakeNode(right->left->right, right->right));
+            }
+            return MakeNode(std::move(left), std::move(right));
+        }
+        // Descends the taller tree until the heights meet, so the cost is their height difference
+        static NodePtr Join(NodePtr left, NodePtr right) {
+            if (!left)
+                return right;
+            if (!right)
+                return left;
+            if (left->IsLeaf() && right->IsLeaf() && left->size + right->size <= Chunk)
+                return MakeLeaf(left->items.cbegin(), left->size, right->items.cbegin(), right->size);
+            if (left->height > right->height + 1)
+                return Balance(left->left, Join(left->right, std::move(right)));
+            if (right->height > left->height + 1)
+                return Balance(Join(std::move(left), right->left), right->right);
+            return MakeNode(std::move(left), std::move(right));
+        }
+        // First count items and the rest
+        static std::pair<NodePtr, NodePtr> Split(const NodePtr& node, int count) {
+            if (count <= 0)
+                return {nullptr, node};
+            if (count >= Size(node))
+                return {node, nullptr};
+            if (node->IsLeaf()) {
+                const T* items = node->items.cbegin();
+                return {MakeLeaf(items, count), MakeLeaf(items + count, node->size - count)};
+            }
+            int leftSize = node->left->size;
+            if (count == leftSize)
+                return {node->left, node->right};
+            if (count < leftSize) {
+                auto parts = Split(node->left, count);
+                return {std::move(parts.first), Join(std::move(parts.second), node->right)};
+            }
+            auto parts = Split(node->right, count - leftSize);
+            return {Join(node->left, std::move(parts.first)), std::move(parts.second)};
+        }
+        // Balanced tree over count items, built bottom-up from full chunks
+        template <typename It>
+        static NodePtr Build(It items, int count) {
+            if (count <= 0)
+                return nullptr;
+            if (count <= Chunk) {
+                DynamicArray<T> leaf;
+                leaf.Reserve(count);
+                leaf.AppendRange(items, std::next(items, count));
+                return MakeLeaf(std::move(leaf));
+            }
+            int leaves = (count + Chunk - 1) / Chunk;
+            int half = (leaves / 2) * Chunk;
+            return MakeNode(Build(items, half), Build(std::next(items, half), count - half));
+        }
+
+        // Node that this rope may write to: a shared one is replaced by a private copy first
+        static Node* Mutable(NodePtr& node) {
+            if (node.use_count() != 1)
+                node = std::make_shared<Node>(*node);
+            return node.get();
+        }
+        const Node* Leaf(int& index) const {
+            const Node* node = root.get();
+            while (!node->IsLeaf()) {
+                if (index < node->left->size) {
+                    node = node->left.get();
+                } else {
+                    index -= node->left->size;
+                    node = node->right.get();
+                }
+            }
+            return node;
+        }
+        static void Insert(NodePtr& node, int index, T&& item) {
+            Node* current = Mutable(node);
+            if (current->IsLeaf()) {
+                if (current->size < Chunk) {
+                    current->items.EmplaceAt(index, std::move(item));
+                    ++current->size;
+                    return;
+                }
+                // A full chunk gets a new neighbour at either end and splits in halves in the middle,
+                // so appending or prepending in a row leaves full chunks behind
+                NodePtr left, right;
+                if (index == 0 || index == Chunk) {
+                    DynamicArray<T> fresh;
+                    fresh.Reserve(Chunk);
+                    fresh.Emplace(std::move(item));
+                    left = index == 0 ? MakeLeaf(std::move(fresh)) : node;
+                    right = index == 0 ? node : MakeLeaf(std::move(fresh));
+                } else {
+                    const T* items = current->items.cbegin();
+                    left = MakeLeaf(items, Chunk / 2);
+                    right = MakeLeaf(items + Chunk / 2, Chunk - Chunk / 2);
+                    if (index <= Chunk / 2)
+                        Insert(left, index, std::move(item));
+                    else
+                        Insert(right, index - Chunk / 2, std::move(item));
+                }
+                node = MakeNode(std::move(left), std::move(right));
+                return;
+            }
+            if (index <= current->left->size)
+                Insert(current->left, index, std::move(item));
+            else
+                Insert(current->right, index - current->left->size, std::move(item));
+            if (std::abs(current->left->height - current->right->height) > 1) {
+                node = Balance(current->left, current->right);
+            } else {
+                ++current->size;
+                current->height = std::max(current->left->height, current->right->height) + 1;
+            }
+        }
+
+        explicit RopeSequence(NodePtr root) : root(std::move(root)) {
+            this->size = Size(this->root);
+        }
+        void CheckIndex(int index, const char* negative, const char* action) const {
+            if (!Lab::InRange(index, this->size))
+                Lab::ThrowIndexOutOfRange(negative, action, index, this->size);
+        }
+    protected:
+        virtual typename Sequence<T>::ConstIterator IteratorAt(int index) const override {
+            if (index >= this->size)
+                return cend();
+            return typename Sequence<T>::ConstIterator(this, index);
+        }
+        virtual void GetChunk(int index, const T*& begin, const T*& end) const override {
+            if (index >= this->size) {
+                begin = end = nullptr;
+                return;
+            }
+            const Node* leaf = Leaf(index);
+            begin = leaf->items.cbegin() + index;
+            end = leaf->items.cend();
+        }
+    public:
+        RopeSequence() {
+            this->size = 0;
+        }
+        // Copies share the whole tree, so they cost O(1) until one of them is written to
+        RopeSequence(const RopeSequence& Sequence) : root(Sequence.root) {
+            this->size = Sequence.size;
+        }
+        RopeSequence(RopeSequence&& Sequence) noexcept : root(std::move(Sequence.root)) {
+            this->size = Sequence.size;
+            Sequence.size = 0;
+        }
+        RopeSequence& operator=(const RopeSequence& Sequence) {
+            root = Sequence.root;
+            this->size = Sequence.size;
+            return *this;
+        }
+        RopeSequence& operator=(RopeSequence&& Sequence) noexcept {
+            std::swap(root, Sequence.root);
+            std::swap(this->size, Sequence.size);
+            return *this;
+        }
+        RopeSequence(const T* items, int size) {
+            if (size < 0)
+                throw std::logic_error("Trying to make a sequence with a negative size: " + std::to_string(size));
+            if (!items && size > 0)
+                throw std::runtime_error("Passing nullptr, assuming it is a non-void array");
+            root = Build(items, size);
+            this->size = size;
+        }
+        explicit RopeSequence(int size) {
+            if (size < 0)
+                throw std::logic_error("Trying to make a sequence with a negative size: " + std::to_string(size));
+            DynamicArray<T> items(size);
+            root = Build(items.cbegin(), size);
+            this->size = size;
+        }
+        virtual ~RopeSequence() {}
+
+        virtual T GetFirst() const override {
+            return Get(0);
+        }
+        virtual T GetLast() const override {
+            return Get(this->size - 1);
+        }
+        virtual T Get(int index) const override {
+            CheckIndex(index, "Went out of range, requesting element with a negative index", "requesting");
+            const Node* leaf = Leaf(index);
+            return leaf->items.cbegin()[index];
+        }
+        virtual void Set(const T& item, int index) override {
+            CheckIndex(index, "Trying to set an element with a negative index", "trying to set");
+            NodePtr* node = &root;
+            for (;;) {
+                Node* current = Mutable(*node);
+                if (current->IsLeaf()) {
+                    current->items.Set(index, item);
+                    return;
+                }
+                if (index < current->left->size) {
+                    node = &current->left;
+                } else {
+                    index -= current->left->size;
+                    node = &current->right;
+                }
+            }
+        }
+        // Shares all of this rope but the O(log n) nodes along the two cuts
+        virtual RopeSequence* GetSubSequence(int start, int end) const override {
+            if (start < 0 || start >= this->size || end < 0 || end > this->size || start > end)
+                throw Lab::IndexOutOfRange("Trying to get subSequence with the wrong bounds");
+            NodePtr head = Split(root, end).first;
+            return new RopeSequence(Split(head, start).second);
+        }
+        virtual void Append(const T& item) override {
+            InsertAt(item, this->size);
+        }
+        virtual void Append(T&& item) override {
+            InsertAt(std::move(item), this->size);
+        }
+        virtual void Prepend(const T& item) override {
+            InsertAt(item, 0);
+        }
+        virtual void Prepend(T&& item) override {
+            InsertAt(std::move(item), 0);
+        }
+        virtual void InsertAt(const T& item, int index) override {
+            InsertAt(T(item), index);
+        }
+        virtual void InsertAt(T&& item, int index) override {
+            if (!Lab::InRange(index, this->size + 1))
+                Lab::ThrowIndexOutOfRange("Went out of range, trying to insert an element at a negative index", "trying to insert", index, this->size);
+            if (!root) {
+                DynamicArray<T> items;
+                items.Reserve(Chunk);
+                items.Emplace(std::move(item));
+                root = MakeLeaf(std::move(items));
+            } else {
+                Insert(root, index, std::move(item));
+            }
+            ++(this->size);
+        }
+        // The range becomes a tree of its own, joined in at index: O(k + log n) for k items
+        template <typename It>
+        void InsertRange(int index, It first, It last) {
+            if (!Lab::InRange(index, this->size + 1))
+                Lab::ThrowIndexOutOfRange("Went out of range, trying to insert an element at a negative index", "trying to insert", index, this->size);
+            int count = static_cast<int>(std::distance(first, last));
+            NodePtr middle = Build(first, count);
+            auto parts = Split(root, index);
+            root = Join(Join(std::move(parts.first), std::move(middle)), std::move(parts.second));
+            this->size += count;
+        }
+        template <typename Range>
+        void InsertRange(int index, const Range& range) {
+            InsertRange(index, std::begin(range), std::end(range));
+        }
+        template <typename It>
+        void AppendRange(It first, It last) {
+            InsertRange(this->size, first, last);
+        }
+        template <typename Range>
+        void AppendRange(const Range& range) {
+            InsertRange(this->size, std::begin(range), std::end(range));
+        }
+        template <typename It>
+        void Assign(It first, It last) {
+            int count = static_cast<int>(std::distance(first, last));
+            root = Build(first, count);
+            this->size = count;
+        }
+        template <typename Range>
+        void Assign(const Range& range) {
+            Assign(std::begin(range), std::end(range));
+        }
+        // O(log n) with another rope, which keeps sharing its tree; other sequences are copied first
+        virtual RopeSequence* Concat(const Sequence<T>& Sequence) const override {
+            if (auto other = dynamic_cast<const RopeSequence*>(&Sequence))
+                return new RopeSequence(Join(root, other->root));
+            DynamicArray<T> items;
+            items.Reserve(Sequence.GetSize());
+            for (const T& item : Sequence)
+                items.Emplace(item);
+            return new RopeSequence(Join(root, Build(items.cbegin(), items.GetSize())));
+        }
+        virtual void Print () const override {
+            std::cout << *this << std::endl;
+        }
+        int GetHeight() const {
+            return Height(root);
+        }
+
+        typename Sequence<T>::ConstIterator cbegin() const {
+            return typename Sequence<T>::ConstIterator(this, 0);
+        }
+        typename Sequence<T>::ConstIterator cend() const {
+            return typename Sequence<T>::ConstIterator();
+        }
+        virtual typename Sequence<T>::ConstIterator begin() const override {
+            return cbegin();
+        }
+        virtual typename Sequence<T>::ConstIterator end() const override {
+            return cend();
+        }
+    };
+}
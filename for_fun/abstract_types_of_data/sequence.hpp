@@ -1,9 +1,66 @@
 namespace Lab {
+    template <typename T>
+    class SequenceView;
+
     template <typename T> 
     class Sequence {
     protected:
         int size = 0;
     public:
+        // Walks contiguous storage by pointer or a list by its nodes. Which one is fixed per
+        // sequence, so the branch in ++ is perfectly predicted and there is no virtual call per element.
+        // Storage made of several contiguous chunks sets limit and owner, and the iterator asks owner
+        // for the next chunk each time it runs off the current one
+        class ConstIterator {
+            const T* ptr = nullptr;
+            const ListNode<T>* node = nullptr;
+            const T* limit = nullptr;
+            const Sequence<T>* owner = nullptr;
+            int next = 0;   // index of the item at limit
+
+            void NextChunk() {
+                owner->GetChunk(next, ptr, limit);
+                next += static_cast<int>(limit - ptr);
+            }
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = T;
+            using difference_type = std::ptrdiff_t;
+            using pointer = const T*;
+            using reference = const T&;
+
+            ConstIterator() = default;
+            explicit ConstIterator(const T* ptr) : ptr(ptr) {}
+            explicit ConstIterator(const ListNode<T>* node) : node(node) {}
+            // Starts at item index of a chunked sequence, the end is a default-constructed iterator
+            ConstIterator(const Sequence<T>* owner, int index) : owner(owner), next(index) {
+                NextChunk();
+            }
+
+            reference operator*() const { return ptr ? *ptr : node->item; }
+            pointer operator->() const { return ptr ? ptr : &(node->item); }
+            ConstIterator& operator++() {
+                if (ptr) {
+                    if (++ptr == limit && owner)
+                        NextChunk();
+                } else {
+                    node = node->next;
+                }
+                return *this;
+            }
+            ConstIterator operator++(int) {
+                ConstIterator prev = *this;
+                ++(*this);
+                return prev;
+            }
+            bool operator==(const ConstIterator& it) const { return ptr == it.ptr && node == it.node; }
+            bool operator!=(const ConstIterator& it) const { return !(*this == it); }
+        };
+        using const_iterator = ConstIterator;
+
+        virtual ~Sequence() {}
+        virtual ConstIterator begin() const = 0;
+        virtual ConstIterator end() const = 0;
         virtual T GetFirst() const = 0;
         virtual T GetLast() const = 0;
         virtual T Get(int index) const = 0;
@@ -11,140 +68,656 @@ namespace Lab {
         virtual Sequence<T>* GetSubSequence(int start, int end) const = 0; //end excluding
         virtual void Set(const T& item, int index) = 0;
         virtual void Append(const T& item) = 0;
+        virtual void Append(T&& item) = 0;
         virtual void Prepend(const T& item) = 0;
+        virtual void Prepend(T&& item) = 0;
         virtual void InsertAt(const T& item, int index) = 0;
+        virtual void InsertAt(T&& item, int index) = 0;
         virtual Sequence<T>* Concat(const Sequence<T>& Sequence) const = 0;
         virtual void Print () const = 0;
+
+        // Non-owning window on [start, end) of this sequence, valid until the sequence is modified
+        // or destroyed. Nothing is copied, only list-backed sequences walk to start
+        SequenceView<T> View(int start, int end) const {
+            if (start < 0 || end > this->size || start > end)
+                throw Lab::IndexOutOfRange("Trying to get a view with the wrong bounds");
+            return SequenceView<T>(this, start, end);
+        }
+    protected:
+        friend class SequenceView<T>;
+
+        // Iterator at item index, index == size gives end()
+        virtual ConstIterator IteratorAt(int index) const {
+            ConstIterator it = begin();
+            for (int i = 0; i < index; ++i)
+                ++it;
+            return it;
+        }
+        // The items when they sit in one contiguous block, nullptr otherwise
+        virtual const T* Data() const {
+            return nullptr;
+        }
+        // Chunked sequences hand out the run of contiguous items starting at index, [begin, end).
+        // Both are null once index reaches the size
+        virtual void GetChunk(int index, const T*& begin, const T*& end) const {
+            (void)index;
+            begin = end = nullptr;
+        }
     };
 
+    template <typename T>
+    std::ostream& operator<<(std::ostream &out, const Sequence<T> &seq) {
+        if (seq.GetSize() == 0)
+            return out << "Empty Sequence";
+        bool first = true;
+        for (const T& item : seq) {
+            if (!first)
+                out << " ";
+            out << item;
+            first = false;
+        }
+        return out;
+    }
+
+    // What Sequence::View returns: the owner, a window on it and iterators at both ends. Get is O(1)
+    // over contiguous storage and costs the owner's Get otherwise
+    template <typename T>
+    class SequenceView {
+        const Sequence<T>* owner;
+        int offset;
+        int size;
+        const T* data;
+        typename Sequence<T>::ConstIterator first, last;
+    public:
+        using value_type = T;
+        using const_iterator = typename Sequence<T>::ConstIterator;
+
+        SequenceView(const Sequence<T>* owner, int start, int end)
+            : owner(owner), offset(start), size(end - start), data(owner->Data()),
+              first(owner->IteratorAt(start)), last(owner->IteratorAt(end)) {
+            if (data)
+                data += start;
+        }
+
+        int GetSize() const {
+            return size;
+        }
+        T Get(int index) const {
+            if (!Lab::InRange(index, size))
+                Lab::ThrowIndexOutOfRange("Went out of range, requesting element with a negative index", "requesting", index, size);
+            return data ? data[index] : owner->Get(offset + index);
+        }
+        T GetFirst() const {
+            return Get(0);
+        }
+        T GetLast() const {
+            return Get(size - 1);
+        }
+        // Window on [start, end) of this view
+        SequenceView<T> View(int start, int end) const {
+            if (start < 0 || end > size || start > end)
+                throw Lab::IndexOutOfRange("Trying to get a view with the wrong bounds");
+            return SequenceView<T>(owner, offset + start, offset + end);
+        }
+
+        const_iterator begin() const { return first; }
+        const_iterator end() const { return last; }
+
+        friend std::ostream& operator<<(std::ostream &out, const SequenceView<T> &view) {
+            if (view.size == 0)
+                return out << "Empty Sequence";
+            bool separate = false;
+            for (const T& item : view) {
+                if (separate)
+                    out << " ";
+                out << item;
+                separate = true;
+            }
+            return out;
+        }
+    };
+
+    // Compile-time counterpart of Sequence. Derived provides GetSize() and non-virtual cbegin()/cend()
+    // with its native iterators, so algorithms written against it inline the whole traversal
+    template <typename Derived, typename T>
+    class StaticSequence {
+    public:
+        using value_type = T;
+
+        Derived& Self() {
+            return static_cast<Derived&>(*this);
+        }
+        const Derived& Self() const {
+            return static_cast<const Derived&>(*this);
+        }
+        template <typename F>
+        void ForEach(F f) const {
+            for (auto it = Self().cbegin(), end = Self().cend(); it != end; ++it)
+                f(*it);
+        }
+        template <typename U, typename Op>
+        U Reduce(U init, Op op) const {
+            for (auto it = Self().cbegin(), end = Self().cend(); it != end; ++it)
+                init = op(std::move(init), *it);
+            return init;
+        }
+    };
+
+    // Copies and subsequences share one DynamicArray and see their own [offset, offset + size) of it.
+    // The first write through a sequence that shares, or sees only part of, its array copies its items
+    // into a private array, so copies and slices cost O(1) until they are modified
     template <typename T> 
-    class ArraySequence : public Sequence<T> {
+    class ArraySequence final : public Sequence<T>, public StaticSequence<ArraySequence<T>, T> {
     protected:
-        DynamicArray<T>* arr;
+        std::shared_ptr<DynamicArray<T>> arr;
+        int offset = 0;
+
+        void CheckInsertIndex(int index) const {
+            if (index < 0) 
+                throw Lab::IndexOutOfRange("Trying to set an element with a negative index");
+            if (index >= this->size)
+                throw Lab::IndexOutOfRange("Went out of range, trying to set " + std::to_string(index) + "-th element in array with length " + std::to_string(this->size));
+        }
+        void CheckIndex(int index) const {
+            if (!Lab::InRange(index, this->size))
+                Lab::ThrowIndexOutOfRange("Went out of range, requesting element with a negative index", "requesting", index, this->size);
+        }
+        bool IsShared() const {
+            return arr.use_count() != 1 || offset != 0 || arr->GetSize() != this->size;
+        }
+        void Detach() {
+            if (!IsShared())
+                return;
+            // The array only reads through the pointer it is given
+            auto own = std::make_shared<DynamicArray<T>>(const_cast<T*>(cbegin()), this->size);
+            own->SetGrowthFactor(arr->GetGrowthFactor());
+            arr = std::move(own);
+            offset = 0;
+        }
+        ArraySequence(const ArraySequence<T>& Sequence, int start, int end) : arr(Sequence.arr), offset(Sequence.offset + start) {
+            this->size = end - start;
+        }
+        virtual typename Sequence<T>::ConstIterator IteratorAt(int index) const override {
+            return typename Sequence<T>::ConstIterator(cbegin() + index);
+        }
+        virtual const T* Data() const override {
+            return cbegin();
+        }
     public:
-        ArraySequence() {
-            this->arr = new DynamicArray<T>();
+        ArraySequence() : arr(std::make_shared<DynamicArray<T>>()) {
             this->size = 0;
         }
-        ArraySequence(const ArraySequence<T>& Sequence) {
-            this->arr = new DynamicArray<T>(*Sequence.arr);
+        ArraySequence(const ArraySequence<T>& Sequence) : arr(Sequence.arr), offset(Sequence.offset) {
             this->size = Sequence.size;
         }
-        ArraySequence(DynamicArray<T>* items) {
-            this->arr = items;
+        ArraySequence(ArraySequence<T>&& Sequence) : arr(std::make_shared<DynamicArray<T>>()) {
+            std::swap(this->arr, Sequence.arr);
+            std::swap(this->offset, Sequence.offset);
+            this->size = Sequence.size;
+            Sequence.size = 0;
+        }
+        ArraySequence<T>& operator=(const ArraySequence<T>& Sequence) {
+            this->arr = Sequence.arr;
+            this->offset = Sequence.offset;
+            this->size = Sequence.size;
+            return *this;
+        }
+        ArraySequence<T>& operator=(ArraySequence<T>&& Sequence) noexcept {
+            std::swap(this->arr, Sequence.arr);
+            std::swap(this->offset, Sequence.offset);
+            std::swap(this->size, Sequence.size);
+            return *this;
+        }
+        ArraySequence(DynamicArray<T>* items) : arr(items) {
             this->size = items->GetSize();
         }
-        ArraySequence(T* items, int size) {
-            this->arr = new DynamicArray<T>(items, size);
+        ArraySequence(T* items, int size) : arr(std::make_shared<DynamicArray<T>>(items, size)) {
             this->size = size;
         }
-        ArraySequence(int size) {
-            this->arr = new DynamicArray<T>(size);
+        ArraySequence(int size) : arr(std::make_shared<DynamicArray<T>>(size)) {
             this->size = size;
         }
         virtual ~ArraySequence() {
-            delete this->arr;
             this->size = 0;
         }
         virtual T GetFirst() const override {
-            return this->arr->Get(0);
+            return Get(0);
         }
         virtual T GetLast() const override {
-            return this->arr->Get(this->size - 1);
+            return Get(this->size - 1);
         }
         virtual T Get(int index) const override {
-            return this->arr->Get(index);
+            CheckIndex(index);
+            return cbegin()[index];
         }
         virtual void Set(const T& item, int index) override {
             if (index < 0 || index >= this->size) 
                 throw Lab::IndexOutOfRange("Trying to set an element with a wrong index");
+            Detach();
             this->arr->Set(index, item);
         }
+        // Shares the items with this sequence until either of them is modified
         virtual ArraySequence<T>* GetSubSequence(int start, int end) const override {
             if (start < 0 || start >= this->size || end < 0 || end > this->size || start > end) 
                 throw Lab::IndexOutOfRange("Trying to get subSequence with the wrong bounds");
-            ArraySequence<T> *sub = new ArraySequence<T>(end - start);
-            for (int i = 0; i < end - start; ++i)
-                sub->Set(this->arr->Get(i + start), i);
-            return sub;
+            return new ArraySequence<T>(*this, start, end);
         }
         virtual void Append(const T& item) override {
-            this->arr->Resize((this->size) + 1);
-            this->arr->Set((this->size), item);
-            ++(this->size);
+            Emplace(item);
+        }
+        virtual void Append(T&& item) override {
+            Emplace(std::move(item));
         }
         virtual void Prepend(const T& item) override {
-            this->arr->Resize(this->size + 1);
-            T a = this->arr->Get(0);
-            T b;
-            for (int i = 0; i < this->size; ++i) {
-                b = a;
-                a = this->arr->Get(i + 1);
-                this->arr->Set(i + 1, b);
-            }
-            this->arr->Set(0, item);
-            ++(this->size);
+            EmplaceAt(0, item);
+        }
+        virtual void Prepend(T&& item) override {
+            EmplaceAt(0, std::move(item));
         }
         virtual void InsertAt(const T& item, int index) override {
-            if (index < 0) 
-                throw Lab::IndexOutOfRange("Trying to set an element with a negative index");
-            if (index >= this->size)
-                throw Lab::IndexOutOfRange("Went out of range, trying to set " + std::to_string(index) + "-th element in array with length " + std::to_string(this->arr->GetSize()));
-            this->arr->Resize(this->size + 1);
-            T a = this->arr->Get(index);
-            T b;
-            for (int i = index; i < this->size; ++i) {
-                b = a;
-                a = this->arr->Get(i + 1);
-                this->arr->Set(i + 1, b);
+            CheckInsertIndex(index);
+            EmplaceAt(index, item);
+        }
+        virtual void InsertAt(T&& item, int index) override {
+            CheckInsertIndex(index);
+            EmplaceAt(index, std::move(item));
+        }
+        template <typename... Args>
+        T& Emplace(Args&&... args) {
+            if (IsShared()) {
+                // Built before detaching, args may refer to the shared items
+                T item(std::forward<Args>(args)...);
+                Detach();
+                return Emplace(std::move(item));
             }
-            this->arr->Set(index, item);
+            T& item = this->arr->Emplace(std::forward<Args>(args)...);
+            ++(this->size);
+            return item;
+        }
+        template <typename... Args>
+        T& EmplaceAt(int index, Args&&... args) {
+            if (IsShared()) {
+                T item(std::forward<Args>(args)...);
+                Detach();
+                return EmplaceAt(index, std::move(item));
+            }
+            T& item = this->arr->EmplaceAt(index, std::forward<Args>(args)...);
             ++(this->size);
+            return item;
+        }
+        // Inserts [first, last) before index with one allocation at most and one shift. A shared array
+        // is never written to: the new one is built from it, the range and the rest in a single pass
+        template <typename It>
+        void InsertRange(int index, It first, It last) {
+            if (!Lab::InRange(index, this->size + 1))
+                Lab::ThrowIndexOutOfRange("Went out of range, trying to insert an element at a negative index", "trying to insert", index, this->size);
+            if (IsShared()) {
+                auto own = std::make_shared<DynamicArray<T>>();
+                own->SetGrowthFactor(arr->GetGrowthFactor());
+                own->Reserve(this->size + static_cast<int>(std::distance(first, last)));
+                own->AppendRange(cbegin(), cbegin() + index);
+                own->AppendRange(first, last);
+                own->AppendRange(cbegin() + index, cend());
+                arr = std::move(own);
+                offset = 0;
+            } else {
+                arr->InsertRange(index, first, last);
+            }
+            this->size = arr->GetSize();
+        }
+        template <typename Range>
+        void InsertRange(int index, const Range& range) {
+            InsertRange(index, std::begin(range), std::end(range));
+        }
+        template <typename It>
+        void AppendRange(It first, It last) {
+            InsertRange(this->size, first, last);
+        }
+        template <typename Range>
+        void AppendRange(const Range& range) {
+            InsertRange(this->size, std::begin(range), std::end(range));
+        }
+        template <typename It>
+        void Assign(It first, It last) {
+            // The old array stays alive until the copy is done, the range may point into it
+            std::shared_ptr<DynamicArray<T>> old;
+            if (IsShared()) {
+                old = std::move(arr);
+                arr = std::make_shared<DynamicArray<T>>();
+                arr->SetGrowthFactor(old->GetGrowthFactor());
+                offset = 0;
+                this->size = 0;
+            }
+            arr->Assign(first, last);
+            this->size = arr->GetSize();
+        }
+        template <typename Range>
+        void Assign(const Range& range) {
+            Assign(std::begin(range), std::end(range));
         }
         virtual ArraySequence<T>* Concat(const Sequence<T>& Sequence) const override {
-            ArraySequence<T>* newSequence = new ArraySequence<T>(this->size + Sequence.GetSize());
-            for (int i = 0; i < this->size; ++i)
-                newSequence->Set(this->Get(i), i);
-            for (int i = 0; i < Sequence.GetSize(); ++i) {
-                newSequence->Set(Sequence.Get(i), i + this->size);
-            }
+            ArraySequence<T>* newSequence = new ArraySequence<T>();
+            newSequence->Reserve(this->size + Sequence.GetSize());
+            for (const T& item : *this)
+                newSequence->Emplace(item);
+            for (const T& item : Sequence)
+                newSequence->Emplace(item);
             return newSequence;
         }
         virtual void Print () const override {
-            std::cout << *(this->arr) << std::endl;
+            if (this->size == 0)
+                std::cout << "Empty DynamicArray" << std::endl;
+            else
+                std::cout << static_cast<const Sequence<T>&>(*this) << std::endl;
+        }
+        void Reserve(int capacity) {
+            Detach();
+            this->arr->Reserve(capacity);
+        }
+        void ShrinkToFit() {
+            Detach();
+            this->arr->ShrinkToFit();
         }
         DynamicArray<T> *getptr() {
-            return arr;
+            Detach();
+            return arr.get();
+        }
+
+        // Mutable iterators detach first, don't keep them across a copy of this sequence
+        using iterator = typename DynamicArray<T>::iterator;
+        iterator begin() { Detach(); return this->arr->begin(); }
+        iterator end() { Detach(); return this->arr->end(); }
+        typename DynamicArray<T>::const_iterator cbegin() const { return this->arr->cbegin() + offset; }
+        typename DynamicArray<T>::const_iterator cend() const { return this->arr->cbegin() + offset + this->size; }
+        virtual typename Sequence<T>::ConstIterator begin() const override {
+            return typename Sequence<T>::ConstIterator(cbegin());
+        }
+        virtual typename Sequence<T>::ConstIterator end() const override {
+            return typename Sequence<T>::ConstIterator(cend());
         }
     };
 
-    template <typename T> 
-    class ListSequence : public Sequence<T> {
+    // ArraySequence that keeps up to N items inside the object and moves them to the heap only when it
+    // outgrows that. A short sequence costs no allocation at all, and no pointer chase to a DynamicArray
+    template <typename T, int N = 16>
+    class SmallArraySequence final : public Sequence<T>, public StaticSequence<SmallArraySequence<T, N>, T> {
+        static_assert(N > 0, "Inline capacity must be positive");
+
+        T* items;
+        int capacity = N;
+        alignas(T) unsigned char buffer[sizeof(T) * N];
+
+        T* Inline() {
+            return reinterpret_cast<T*>(buffer);
+        }
+        static T* Allocate(int count) {
+            if (alignof(T) > __STDCPP_DEFAULT_NEW_ALIGNMENT__)
+                return static_cast<T*>(::operator new(sizeof(T) * count, std::align_val_t(alignof(T))));
+            return static_cast<T*>(::operator new(sizeof(T) * count));
+        }
+        static void Deallocate(T* ptr) {
+            if (alignof(T) > __STDCPP_DEFAULT_NEW_ALIGNMENT__)
+                ::operator delete(ptr, std::align_val_t(alignof(T)));
+            else
+                ::operator delete(ptr);
+        }
+        void Reallocate(int newCapacity) {
+            T* ptr = Allocate(newCapacity);
+            try {
+                if (std::is_nothrow_move_constructible<T>::value || !std::is_copy_constructible<T>::value)
+                    std::uninitialized_move_n(items, this->size, ptr);
+                else
+                    std::uninitialized_copy_n(items, this->size, ptr);
+            } catch (...) {
+                Deallocate(ptr);
+                throw;
+            }
+            std::destroy_n(items, this->size);
+            if (!IsInline())
+                Deallocate(items);
+            items = ptr;
+            capacity = newCapacity;
+        }
+        void Grow(int minCapacity) {
+            Reallocate(static_cast<int>(std::max<long long>(minCapacity, std::min<long long>(2LL * capacity, std::numeric_limits<int>::max()))));
+        }
+        // Leaves an empty sequence on the inline buffer
+        void Release() {
+            std::destroy_n(items, this->size);
+            if (!IsInline())
+                Deallocate(items);
+            items = Inline();
+            capacity = N;
+            this->size = 0;
+        }
+        // Takes the heap buffer of an empty this, or moves the items one by one out of an inline one
+        void Steal(SmallArraySequence& other) noexcept(std::is_nothrow_move_constructible<T>::value) {
+            if (other.IsInline()) {
+                std::uninitialized_move_n(other.items, other.size, items);
+                this->size = other.size;
+                std::destroy_n(other.items, other.size);
+            } else {
+                items = other.items;
+                capacity = other.capacity;
+                this->size = other.size;
+                other.items = other.Inline();
+                other.capacity = N;
+            }
+            other.size = 0;
+        }
+        void CheckIndex(int index, const char* negative, const char* action) const {
+            if (!Lab::InRange(index, this->size))
+                Lab::ThrowIndexOutOfRange(negative, action, index, this->size);
+        }
+        virtual typename Sequence<T>::ConstIterator IteratorAt(int index) const override {
+            return typename Sequence<T>::ConstIterator(items + index);
+        }
+        virtual const T* Data() const override {
+            return items;
+        }
+    public:
+        SmallArraySequence() : items(Inline()) {
+            this->size = 0;
+        }
+        SmallArraySequence(const SmallArraySequence& Sequence) : SmallArraySequence() {
+            Reserve(Sequence.size);
+            std::uninitialized_copy_n(Sequence.items, Sequence.size, items);
+            this->size = Sequence.size;
+        }
+        SmallArraySequence(SmallArraySequence&& Sequence) noexcept(std::is_nothrow_move_constructible<T>::value) : SmallArraySequence() {
+            Steal(Sequence);
+        }
+        SmallArraySequence& operator=(const SmallArraySequence& Sequence) {
+            if (this != &Sequence) {
+                SmallArraySequence copy(Sequence);
+                Release();
+                Steal(copy);
+            }
+            return *this;
+        }
+        SmallArraySequence& operator=(SmallArraySequence&& Sequence) noexcept(std::is_nothrow_move_constructible<T>::value) {
+            if (this != &Sequence) {
+                Release();
+                Steal(Sequence);
+            }
+            return *this;
+        }
+        SmallArraySequence(const T* items, int size) : SmallArraySequence() {
+            if (size < 0)
+                throw std::logic_error("Trying to make a sequence with a negative size: " + std::to_string(size));
+            if (!items && size > 0)
+                throw std::runtime_error("Passing nullptr, assuming it is a non-void array");
+            Reserve(size);
+            std::uninitialized_copy_n(items, size, this->items);
+            this->size = size;
+        }
+        explicit SmallArraySequence(int size) : SmallArraySequence() {
+            if (size < 0)
+                throw std::logic_error("Trying to make a sequence with a negative size: " + std::to_string(size));
+            Reserve(size);
+            std::uninitialized_value_construct_n(items, size);
+            this->size = size;
+        }
+        virtual ~SmallArraySequence() {
+            Release();
+        }
+        virtual T GetFirst() const override {
+            CheckIndex(0, "Trying to get the first element of an empty sequence", "requesting");
+            return items[0];
+        }
+        virtual T GetLast() const override {
+            CheckIndex(this->size - 1, "Trying to get the last element of an empty sequence", "requesting");
+            return items[this->size - 1];
+        }
+        virtual T Get(int index) const override {
+            CheckIndex(index, "Went out of range, requesting element with a negative index", "requesting");
+            return items[index];
+        }
+        T& operator[](int index) {
+            CheckIndex(index, "Went out of range, requesting element with a negative index", "requesting");
+            return items[index];
+        }
+        const T& operator[](int index) const {
+            CheckIndex(index, "Went out of range, requesting element with a negative index", "requesting");
+            return items[index];
+        }
+        virtual void Set(const T& item, int index) override {
+            CheckIndex(index, "Trying to set an element with a negative index", "trying to set");
+            items[index] = item;
+        }
+        virtual SmallArraySequence* GetSubSequence(int start, int end) const override {
+            if (start < 0 || start >= this->size || end < 0 || end > this->size || start > end) 
+                throw Lab::IndexOutOfRange("Trying to get subSequence with the wrong bounds");
+            return new SmallArraySequence(items + start, end - start);
+        }
+        virtual void Append(const T& item) override {
+            Emplace(item);
+        }
+        virtual void Append(T&& item) override {
+            Emplace(std::move(item));
+        }
+        virtual void Prepend(const T& item) override {
+            EmplaceAt(0, item);
+        }
+        virtual void Prepend(T&& item) override {
+            EmplaceAt(0, std::move(item));
+        }
+        virtual void InsertAt(const T& item, int index) override {
+            CheckIndex(index, "Trying to set an element with a negative index", "trying to set");
+            EmplaceAt(index, item);
+        }
+        virtual void InsertAt(T&& item, int index) override {
+            CheckIndex(index, "Trying to set an element with a negative index", "trying to set");
+            EmplaceAt(index, std::move(item));
+        }
+        template <typename... Args>
+        T& Emplace(Args&&... args) {
+            if (this->size == capacity) {
+                // Built before growing, args may refer to an element of this sequence
+                T item(std::forward<Args>(args)...);
+                Grow(this->size + 1);
+                ::new (static_cast<void*>(items + this->size)) T(std::move(item));
+            } else {
+                ::new (static_cast<void*>(items + this->size)) T(std::forward<Args>(args)...);
+            }
+            return items[this->size++];
+        }
+        template <typename... Args>
+        T& EmplaceAt(int index, Args&&... args) {
+            if (!Lab::InRange(index, this->size + 1))
+                Lab::ThrowIndexOutOfRange("Went out of range, trying to insert an element at a negative index", "trying to insert", index, this->size);
+            T item(std::forward<Args>(args)...);
+            if (this->size == capacity)
+                Grow(this->size + 1);
+            if (index == this->size) {
+                ::new (static_cast<void*>(items + this->size)) T(std::move(item));
+            } else {
+                ::new (static_cast<void*>(items + this->size)) T(std::move(items[this->size - 1]));
+                std::move_backward(items + index, items + this->size - 1, items + this->size);
+                items[index] = std::move(item);
+            }
+            ++(this->size);
+            return items[index];
+        }
+        virtual SmallArraySequence* Concat(const Sequence<T>& Sequence) const override {
+            SmallArraySequence* newSequence = new SmallArraySequence(items, this->size);
+            newSequence->Reserve(this->size + Sequence.GetSize());
+            for (const T& item : Sequence)
+                newSequence->Emplace(item);
+            return newSequence;
+        }
+        virtual void Print () const override {
+            std::cout << *this << std::endl;
+        }
+        void Reserve(int newCapacity) {
+            if (newCapacity < 0)
+                throw std::logic_error("Trying to reserve a negative capacity: " + std::to_string(newCapacity));
+            if (newCapacity > capacity)
+                Reallocate(newCapacity);
+        }
+        int GetCapacity() const {
+            return capacity;
+        }
+        // True while the items still live inside the object
+        bool IsInline() const {
+            return items == reinterpret_cast<const T*>(buffer);
+        }
+
+        using iterator = T*;
+        iterator begin() { return items; }
+        iterator end() { return items + this->size; }
+        const T* cbegin() const { return items; }
+        const T* cend() const { return items + this->size; }
+        virtual typename Sequence<T>::ConstIterator begin() const override {
+            return typename Sequence<T>::ConstIterator(cbegin());
+        }
+        virtual typename Sequence<T>::ConstIterator end() const override {
+            return typename Sequence<T>::ConstIterator(cend());
+        }
+    };
+
+    // Copies share one list until either of them is modified, the first write copies it
+    template <typename T, typename Allocator = Lab::PoolAllocator<T>> 
+    class ListSequence final : public Sequence<T>, public StaticSequence<ListSequence<T, Allocator>, T> {
     protected:
-        LinkedList<T>* list;
+        std::shared_ptr<LinkedList<T, Allocator>> list;
+
+        void Detach() {
+            if (list.use_count() != 1)
+                list = std::make_shared<LinkedList<T, Allocator>>(*list);
+        }
     public:
-        ListSequence() {
-            this->list = new LinkedList<T>();
+        ListSequence() : list(std::make_shared<LinkedList<T, Allocator>>()) {
             this->size = 0;
         }
-        ListSequence(const ListSequence<T>& Sequence) {
-            this->list = new LinkedList<T>(*Sequence.list);
+        ListSequence(const ListSequence<T, Allocator>& Sequence) : list(Sequence.list) {
+            this->size = Sequence.size;
+        }
+        ListSequence(ListSequence<T, Allocator>&& Sequence) : list(std::make_shared<LinkedList<T, Allocator>>()) {
+            std::swap(this->list, Sequence.list);
             this->size = Sequence.size;
+            Sequence.size = 0;
         }
-        ListSequence(LinkedList<T>* list) {
-            this->list = list;
+        ListSequence<T, Allocator>& operator=(const ListSequence<T, Allocator>& Sequence) {
+            this->list = Sequence.list;
+            this->size = Sequence.size;
+            return *this;
+        }
+        ListSequence<T, Allocator>& operator=(ListSequence<T, Allocator>&& Sequence) noexcept {
+            std::swap(this->list, Sequence.list);
+            std::swap(this->size, Sequence.size);
+            return *this;
+        }
+        ListSequence(LinkedList<T, Allocator>* list) : list(list) {
             this->size = list->GetLength();
         }
-        ListSequence(T* items, int size) {
-            this->list = new LinkedList<T>(items, size);
+        ListSequence(T* items, int size) : list(std::make_shared<LinkedList<T, Allocator>>(items, size)) {
             this->size = size;
         }
-        ListSequence(int size) {
-            this->list = new LinkedList<T>(size);
+        ListSequence(int size) : list(std::make_shared<LinkedList<T, Allocator>>(size)) {
             this->size = size;
         }
         virtual ~ListSequence() {
-            delete this->list;
             this->size = 0;
         }
         virtual T GetFirst() const override {
@@ -156,36 +729,133 @@ namespace Lab {
         virtual T Get(int index) const override {
             return this->list->Get(index);
         }
-        virtual ListSequence<T>* GetSubSequence(int start, int end) const override {
-            LinkedList<T>* subList = this->list->GetSubList(start, end);
-            ListSequence<T>* Sequence = new ListSequence<T>(subList);
+        virtual ListSequence<T, Allocator>* GetSubSequence(int start, int end) const override {
+            LinkedList<T, Allocator>* subList = this->list->GetSubList(start, end);
+            ListSequence<T, Allocator>* Sequence = new ListSequence<T, Allocator>(subList);
             return Sequence;
         }
         virtual void Set(const T& item, int index) override {
+            Detach();
             this->list->Set(item, index);
         }
         virtual void Append(const T& item) override {
-            this->list->Append(item);
-            ++(this->size);
+            Emplace(item);
+        }
+        virtual void Append(T&& item) override {
+            Emplace(std::move(item));
         }
         virtual void Prepend(const T& item) override {
-            this->list->Prepend(item);
-            ++(this->size);
+            EmplaceAt(0, item);
+        }
+        virtual void Prepend(T&& item) override {
+            EmplaceAt(0, std::move(item));
         }
         virtual void InsertAt(const T& item, int index) override {
-            this->list->InsertAt(item, index);
-            ++(this->size);
+            EmplaceAt(index, item);
         }
-        virtual ListSequence<T>* Concat(const Sequence<T>& Sequence) const override {
-            ListSequence<T>* newSequence = new ListSequence<T>();
-            for (int i = 0; i < this->size; ++i)
-                newSequence->Append(this->Get(i));
-            for (int i = 0; i < Sequence.GetSize(); ++i)
-                newSequence->Append(Sequence.Get(i));
+        virtual void InsertAt(T&& item, int index) override {
+            EmplaceAt(index, std::move(item));
+        }
+        template <typename... Args>
+        T& Emplace(Args&&... args) {
+            if (list.use_count() != 1) {
+                T item(std::forward<Args>(args)...);
+                Detach();
+                return Emplace(std::move(item));
+            }
+            T& item = this->list->Emplace(std::forward<Args>(args)...);
+            ++(this->size);
+            return item;
+        }
+        template <typename... Args>
+        T& EmplaceAt(int index, Args&&... args) {
+            if (list.use_count() != 1) {
+                T item(std::forward<Args>(args)...);
+                Detach();
+                return EmplaceAt(index, std::move(item));
+            }
+            T& item = this->list->EmplaceAt(index, std::forward<Args>(args)...);
+            ++(this->size);
+            return item;
+        }
+        // Links all of [first, last) in with one walk to index instead of one per item
+        template <typename It>
+        void InsertRange(int index, It first, It last) {
+            Detach();
+            this->list->InsertRange(index, first, last);
+            this->size = this->list->GetLength();
+        }
+        template <typename Range>
+        void InsertRange(int index, const Range& range) {
+            InsertRange(index, std::begin(range), std::end(range));
+        }
+        template <typename It>
+        void AppendRange(It first, It last) {
+            InsertRange(this->size, first, last);
+        }
+        template <typename Range>
+        void AppendRange(const Range& range) {
+            InsertRange(this->size, std::begin(range), std::end(range));
+        }
+        template <typename It>
+        void Assign(It first, It last) {
+            std::shared_ptr<LinkedList<T, Allocator>> old;
+            if (list.use_count() != 1) {
+                old = std::move(list);
+                list = std::make_shared<LinkedList<T, Allocator>>();
+            }
+            this->list->Assign(first, last);
+            this->size = this->list->GetLength();
+        }
+        template <typename Range>
+        void Assign(const Range& range) {
+            Assign(std::begin(range), std::end(range));
+        }
+        virtual ListSequence<T, Allocator>* Concat(const Sequence<T>& Sequence) const override {
+            if (auto other = dynamic_cast<const ListSequence<T, Allocator>*>(&Sequence))
+                return new ListSequence<T, Allocator>(this->list->Concat(*other->list));
+            ListSequence<T, Allocator>* newSequence = new ListSequence<T, Allocator>(*this);
+            for (const T& item : Sequence)
+                newSequence->Append(item);
             return newSequence;
         }
         virtual void Print () const override {
             std::cout << *(this->list) << std::endl;
         }
+        LinkedList<T, Allocator> *getptr() {
+            Detach();
+            return list.get();
+        }
+
+        using iterator = typename LinkedList<T, Allocator>::iterator;
+        // Mutable iterators detach first, don't keep them across a copy of this sequence
+        iterator begin() { Detach(); return this->list->begin(); }
+        iterator end() { Detach(); return this->list->end(); }
+        typename LinkedList<T, Allocator>::const_iterator cbegin() const { return this->list->cbegin(); }
+        typename LinkedList<T, Allocator>::const_iterator cend() const { return this->list->cend(); }
+        virtual typename Sequence<T>::ConstIterator begin() const override {
+            return typename Sequence<T>::ConstIterator(this->list->cbegin().GetNode());
+        }
+        virtual typename Sequence<T>::ConstIterator end() const override {
+            return typename Sequence<T>::ConstIterator(this->list->cend().GetNode());
+        }
     };
+
+    template <typename Derived, typename T>
+    T Sum(const StaticSequence<Derived, T>& seq) {
+        return seq.Reduce(T(), [](T acc, const T& item) { return acc + item; });
+    }
+
+    // Inclusive prefix sums
+    template <typename Derived, typename T>
+    ArraySequence<T>* Scan(const StaticSequence<Derived, T>& seq) {
+        ArraySequence<T>* result = new ArraySequence<T>();
+        result->Reserve(seq.Self().GetSize());
+        T acc = T();
+        seq.ForEach([&](const T& item) {
+            acc = acc + item;
+            result->Emplace(acc);
+        });
+        return result;
+    }
 }
\ No newline at end of file
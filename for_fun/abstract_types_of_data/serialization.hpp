@@ -0,0 +1,252 @@
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#define LAB_SERIALIZATION_MMAP 1
+#else
+#define LAB_SERIALIZATION_MMAP 0
+#endif
+
+namespace Lab {
+    // On-disk layout: a 64-byte header followed by the values, packed row after row for a triangle
+    // matrix. Values are raw native bytes, so the values start 64-byte aligned in a mapped file.
+    // byteOrder tells the loader when a file comes from a host of the other endianness
+    struct BinaryHeader {
+        char magic[4];              // "LABT" for a triangle matrix, "LABS" for a sequence
+        std::uint32_t version;
+        std::uint32_t byteOrder;
+        char kind;                  // 'f' floating point, 'i' signed, 'u' unsigned integer
+        std::uint8_t elementSize;
+        std::uint8_t upper;
+        std::uint8_t reserved;
+        std::int64_t size;          // matrix order or sequence length
+        std::int64_t count;         // values after the header
+        char padding[32];
+    };
+    static_assert(sizeof(BinaryHeader) == 64, "BinaryHeader must stay 64 bytes");
+
+    namespace Binary {
+        constexpr std::uint32_t Version = 1;
+        constexpr std::uint32_t ByteOrder = 0x01020304;
+
+        template <typename T>
+        constexpr char Kind() {
+            return std::is_floating_point<T>::value ? 'f' : std::is_signed<T>::value ? 'i' : 'u';
+        }
+
+        template <typename T>
+        BinaryHeader MakeHeader(const char* magic, long long size, bool upper) {
+            static_assert(std::is_arithmetic<T>::value, "Only arithmetic values have a binary format");
+            BinaryHeader header;
+            std::memset(&header, 0, sizeof(header));
+            std::memcpy(header.magic, magic, 4);
+            header.version = Version;
+            header.byteOrder = ByteOrder;
+            header.kind = Kind<T>();
+            header.elementSize = sizeof(T);
+            header.upper = upper;
+            header.size = size;
+            return header;
+        }
+
+        inline std::runtime_error FileError(const std::string& what, const std::string& path) {
+            return std::runtime_error(what + " " + path + ": " + std::strerror(errno));
+        }
+
+        template <typename T>
+        void Check(const BinaryHeader& header, const char* magic, const std::string& path) {
+            if (std::memcmp(header.magic, magic, 4) != 0)
+                throw std::runtime_error(path + " is not a " + (magic[3] == 'T' ? "triangle matrix" : "sequence") + " file");
+            if (header.version != Version)
+                throw std::runtime_error(path + " has unsupported version " + std::to_string(header.version));
+            if (header.byteOrder != ByteOrder)
+                throw std::runtime_error(path + " was written on a host with a different byte order");
+            if (header.kind != Kind<T>() || header.elementSize != sizeof(T))
+                throw std::runtime_error(path + " holds values of another type");
+            if (header.size < 0 || header.count < 0 || header.count > std::numeric_limits<int>::max())
+                throw std::runtime_error(path + " has a corrupted header");
+        }
+
+        // Copy-on-write mapping of a whole file, unmapped with the last owner
+        class MappedFile {
+            void* address = nullptr;
+            std::size_t length = 0;
+        public:
+            explicit MappedFile(const std::string& path) {
+#if LAB_SERIALIZATION_MMAP
+                int fd = ::open(path.c_str(), O_RDONLY);
+                if (fd < 0)
+                    throw FileError("Can't open", path);
+                struct stat info;
+                if (::fstat(fd, &info) != 0) {
+                    ::close(fd);
+                    throw FileError("Can't stat", path);
+                }
+                length = static_cast<std::size_t>(info.st_size);
+                if (length < sizeof(BinaryHeader)) {
+                    ::close(fd);
+                    throw std::runtime_error(path + " is too short for a header");
+                }
+                // Private pages: writing to a loaded object never reaches the file
+                address = ::mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+                ::close(fd);
+                if (address == MAP_FAILED) {
+                    address = nullptr;
+                    throw FileError("Can't map", path);
+                }
+#else
+                throw std::runtime_error("Memory mapping is not supported on this platform");
+#endif
+            }
+            MappedFile(const MappedFile&) = delete;
+            MappedFile& operator=(const MappedFile&) = delete;
+            ~MappedFile() {
+#if LAB_SERIALIZATION_MMAP
+                if (address)
+                    ::munmap(address, length);
+#endif
+            }
+
+            char* Data() const {
+                return static_cast<char*>(address);
+            }
+            std::size_t Length() const {
+                return length;
+            }
+        };
+
+        // Maps path and checks its header, the values come back borrowed from the mapping
+        template <typename T>
+        DynamicArray<T> Map(const std::string& path, const char* magic, BinaryHeader& header) {
+            auto file = std::make_shared<MappedFile>(path);
+            std::memcpy(&header, file->Data(), sizeof(header));
+            Check<T>(header, magic, path);
+            if (file->Length() < sizeof(header) + header.count * sizeof(T))
+                throw std::runtime_error(path + " is truncated");
+            T* values = reinterpret_cast<T*>(file->Data() + sizeof(header));
+            return DynamicArray<T>(values, static_cast<int>(header.count), std::move(file));
+        }
+    }
+
+    // Streams values to a file without holding them all in memory. The header is written last, so a
+    // file whose writer was never closed fails to load. Built with a size and a flag it writes a
+    // triangle matrix and expects exactly the n(n+1)/2 stored cells, row after row
+    template <typename T>
+    class BinaryWriter {
+        static constexpr int BufferItems = 1 << 16;
+
+        std::ofstream out;
+        std::string path;
+        BinaryHeader header;
+        long long expected = -1;
+        std::vector<T> buffer;
+
+        void Flush() {
+            if (!buffer.empty())
+                out.write(reinterpret_cast<const char*>(buffer.data()), buffer.size() * sizeof(T));
+            buffer.clear();
+            if (!out)
+                throw Binary::FileError("Can't write", path);
+        }
+        void Open() {
+            out.open(path, std::ios::binary | std::ios::trunc);
+            if (!out)
+                throw Binary::FileError("Can't create", path);
+            // Zeroes until Close writes the real header
+            const char placeholder[sizeof(BinaryHeader)] = {};
+            out.write(placeholder, sizeof(placeholder));
+            buffer.reserve(BufferItems);
+        }
+    public:
+        explicit BinaryWriter(const std::string& path) : path(path), header(Binary::MakeHeader<T>("LABS", 0, false)) {
+            Open();
+        }
+        BinaryWriter(const std::string& path, int size, bool upper) : path(path), header(Binary::MakeHeader<T>("LABT", size, upper)) {
+            if (size < 0)
+                throw std::logic_error("Negative size");
+            expected = (long long)size * (size + 1) / 2;
+            Open();
+        }
+        BinaryWriter(const BinaryWriter&) = delete;
+        BinaryWriter& operator=(const BinaryWriter&) = delete;
+        ~BinaryWriter() {
+            // A writer dropped without Close leaves the zeroed header behind, the file won't load
+            if (out.is_open())
+                out.close();
+        }
+
+        void Append(const T& item) {
+            if (expected >= 0 && header.count == expected)
+                throw Lab::IndexOutOfRange("Triangle matrix " + path + " already has all of its cells");
+            buffer.push_back(item);
+            ++header.count;
+            if ((int)buffer.size() == BufferItems)
+                Flush();
+        }
+
+        void Write(const T* items, int count) {
+            if (count < 0)
+                throw std::logic_error("Trying to write a negative count: " + std::to_string(count));
+            if (expected >= 0 && header.count + count > expected)
+                throw Lab::IndexOutOfRange("Triangle matrix " + path + " can't take " + std::to_string(count) + " more cells");
+            Flush();
+            out.write(reinterpret_cast<const char*>(items), (std::streamsize)count * sizeof(T));
+            header.count += count;
+            if (!out)
+                throw Binary::FileError("Can't write", path);
+        }
+
+        long long GetCount() const {
+            return header.count;
+        }
+
+        void Close() {
+            if (!out.is_open())
+                return;
+            if (expected >= 0 && header.count != expected)
+                throw std::logic_error("Triangle matrix " + path + " got " + std::to_string(header.count) + " of " + std::to_string(expected) + " cells");
+            Flush();
+            if (expected < 0)
+                header.size = header.count;
+            out.seekp(0);
+            out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            out.close();
+            if (!out)
+                throw Binary::FileError("Can't write", path);
+        }
+    };
+
+    template <typename T, template <typename> class Storage, typename Check>
+    void Save(const Triangle_Matrix<T, Storage, Check>& matrix, const std::string& path) {
+        BinaryWriter<T> writer(path, matrix.GetSize(), matrix.GetIsUpper());
+        matrix.ForEachStored([&](const T& item) { writer.Append(item); });
+        writer.Close();
+    }
+
+    template <typename T>
+    void Save(const Sequence<T>& sequence, const std::string& path) {
+        BinaryWriter<T> writer(path);
+        for (const T& item : sequence)
+            writer.Append(item);
+        writer.Close();
+    }
+
+    // Zero-copy loaders: the objects read straight from the mapped file, which stays mapped until
+    // they are deleted. Loading costs the same for any file size, pages come in as they are touched
+    template <typename T>
+    const Triangle_Matrix<T>* LoadTriangleMatrix(const std::string& path) {
+        BinaryHeader header;
+        DynamicArray<T> cells = Binary::Map<T>(path, "LABT", header);
+        if (header.size > std::numeric_limits<int>::max())
+            throw std::runtime_error(path + " has a corrupted header");
+        return new Triangle_Matrix<T>(PackedTriangleStorage<T>(static_cast<int>(header.size), header.upper != 0, std::move(cells)));
+    }
+
+    template <typename T>
+    const ArraySequence<T>* LoadArraySequence(const std::string& path) {
+        BinaryHeader header;
+        DynamicArray<T> items = Binary::Map<T>(path, "LABS", header);
+        return new ArraySequence<T>(new DynamicArray<T>(std::move(items)));
+    }
+}
@@ -0,0 +1,473 @@
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define LAB_KERNELS_X86 1
+#else
+#define LAB_KERNELS_X86 0
+#endif
+
+namespace Lab {
+    // Flat kernels over contiguous buffers, used by Triangle_Matrix on packed storage.
+    // The instruction set is picked once at runtime, every kernel has a scalar fallback.
+    namespace Kernels {
+        enum class Level { Scalar, SSE2, AVX2 };
+
+        inline Level DetectLevel() {
+#if LAB_KERNELS_X86
+            __builtin_cpu_init();
+            if (__builtin_cpu_supports("avx2"))
+                return Level::AVX2;
+            if (__builtin_cpu_supports("sse2"))
+                return Level::SSE2;
+#endif
+            return Level::Scalar;
+        }
+
+        inline Level& ActiveLevel() {
+            static Level level = DetectLevel();
+            return level;
+        }
+
+        inline Level GetLevel() {
+            return ActiveLevel();
+        }
+
+        // Lets benchmarks pin a lower level, asking for more than the CPU has is clamped
+        inline void SetLevel(Level level) {
+            ActiveLevel() = std::min(level, DetectLevel());
+        }
+
+        // Compensated (Kahan) summation, the low-order bits lost by each addition are carried in c
+        struct KahanSum {
+            double sum = 0;
+            double c = 0;
+            void Add(double x) {
+                double y = x - c;
+                double t = sum + y;
+                c = (t - sum) - y;
+                sum = t;
+            }
+        };
+
+        template <typename T>
+        void AddScalar(T* a, const T* b, int n) {
+            for (int i = 0; i < n; ++i)
+                a[i] = a[i] + b[i];
+        }
+
+        template <typename T>
+        void ScaleScalar(T* a, T c, int n) {
+            for (int i = 0; i < n; ++i)
+                a[i] = a[i] * c;
+        }
+
+        template <typename T>
+        double SumSquaresScalar(const T* a, int n) {
+            KahanSum acc;
+            for (int i = 0; i < n; ++i) {
+                double x = static_cast<double>(a[i]);
+                acc.Add(x * x);
+            }
+            return acc.sum;
+        }
+
+        template <typename T>
+        T DotScalar(const T* a, const T* b, int n) {
+            T sum = T();
+            for (int i = 0; i < n; ++i)
+                sum = sum + a[i] * b[i];
+            return sum;
+        }
+
+        template <typename T>
+        void AxpyScalar(T* y, T a, const T* x, int n) {
+            for (int i = 0; i < n; ++i)
+                y[i] = y[i] + a * x[i];
+        }
+
+#if LAB_KERNELS_X86
+        __attribute__((target("avx2"))) inline void KahanStep(__m256d& sum, __m256d& c, __m256d x) {
+            __m256d y = _mm256_sub_pd(_mm256_mul_pd(x, x), c);
+            __m256d t = _mm256_add_pd(sum, y);
+            c = _mm256_sub_pd(_mm256_sub_pd(t, sum), y);
+            sum = t;
+        }
+
+        __attribute__((target("avx2"))) inline double KahanReduce(__m256d sum, __m256d c) {
+            alignas(32) double sums[4], comps[4];
+            _mm256_store_pd(sums, sum);
+            _mm256_store_pd(comps, c);
+            KahanSum acc;
+            for (int k = 0; k < 4; ++k) {
+                acc.Add(sums[k]);
+                acc.Add(-comps[k]);
+            }
+            return acc.sum - acc.c;
+        }
+
+        __attribute__((target("sse2"))) inline void KahanStep(__m128d& sum, __m128d& c, __m128d x) {
+            __m128d y = _mm_sub_pd(_mm_mul_pd(x, x), c);
+            __m128d t = _mm_add_pd(sum, y);
+            c = _mm_sub_pd(_mm_sub_pd(t, sum), y);
+            sum = t;
+        }
+
+        __attribute__((target("sse2"))) inline double KahanReduce(__m128d sum, __m128d c) {
+            alignas(16) double sums[2], comps[2];
+            _mm_store_pd(sums, sum);
+            _mm_store_pd(comps, c);
+            KahanSum acc;
+            for (int k = 0; k < 2; ++k) {
+                acc.Add(sums[k]);
+                acc.Add(-comps[k]);
+            }
+            return acc.sum - acc.c;
+        }
+
+        // double
+
+        __attribute__((target("avx2"))) inline void AddAvx2(double* a, const double* b, int n) {
+            int i = 0;
+            for (; i + 4 <= n; i += 4)
+                _mm256_storeu_pd(a + i, _mm256_add_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i)));
+            AddScalar(a + i, b + i, n - i);
+        }
+        __attribute__((target("sse2"))) inline void AddSse2(double* a, const double* b, int n) {
+            int i = 0;
+            for (; i + 2 <= n; i += 2)
+                _mm_storeu_pd(a + i, _mm_add_pd(_mm_loadu_pd(a + i), _mm_loadu_pd(b + i)));
+            AddScalar(a + i, b + i, n - i);
+        }
+        __attribute__((target("avx2"))) inline void ScaleAvx2(double* a, double c, int n) {
+            __m256d factor = _mm256_set1_pd(c);
+            int i = 0;
+            for (; i + 4 <= n; i += 4)
+                _mm256_storeu_pd(a + i, _mm256_mul_pd(_mm256_loadu_pd(a + i), factor));
+            ScaleScalar(a + i, c, n - i);
+        }
+        __attribute__((target("sse2"))) inline void ScaleSse2(double* a, double c, int n) {
+            __m128d factor = _mm_set1_pd(c);
+            int i = 0;
+            for (; i + 2 <= n; i += 2)
+                _mm_storeu_pd(a + i, _mm_mul_pd(_mm_loadu_pd(a + i), factor));
+            ScaleScalar(a + i, c, n - i);
+        }
+        __attribute__((target("avx2"))) inline double SumSquaresAvx2(const double* a, int n) {
+            __m256d sum = _mm256_setzero_pd(), c = _mm256_setzero_pd();
+            int i = 0;
+            for (; i + 4 <= n; i += 4)
+                KahanStep(sum, c, _mm256_loadu_pd(a + i));
+            return KahanReduce(sum, c) + SumSquaresScalar(a + i, n - i);
+        }
+        __attribute__((target("sse2"))) inline double SumSquaresSse2(const double* a, int n) {
+            __m128d sum = _mm_setzero_pd(), c = _mm_setzero_pd();
+            int i = 0;
+            for (; i + 2 <= n; i += 2)
+                KahanStep(sum, c, _mm_loadu_pd(a + i));
+            return KahanReduce(sum, c) + SumSquaresScalar(a + i, n - i);
+        }
+
+        // float, squares are widened to double before accumulating
+
+        __attribute__((target("avx2"))) inline void AddAvx2(float* a, const float* b, int n) {
+            int i = 0;
+            for (; i + 8 <= n; i += 8)
+                _mm256_storeu_ps(a + i, _mm256_add_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i)));
+            AddScalar(a + i, b + i, n - i);
+        }
+        __attribute__((target("sse2"))) inline void AddSse2(float* a, const float* b, int n) {
+            int i = 0;
+            for (; i + 4 <= n; i += 4)
+                _mm_storeu_ps(a + i, _mm_add_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+            AddScalar(a + i, b + i, n - i);
+        }
+        __attribute__((target("avx2"))) inline void ScaleAvx2(float* a, float c, int n) {
+            __m256 factor = _mm256_set1_ps(c);
+            int i = 0;
+            for (; i + 8 <= n; i += 8)
+                _mm256_storeu_ps(a + i, _mm256_mul_ps(_mm256_loadu_ps(a + i), factor));
+            ScaleScalar(a + i, c, n - i);
+        }
+        __attribute__((target("sse2"))) inline void ScaleSse2(float* a, float c, int n) {
+            __m128 factor = _mm_set1_ps(c);
+            int i = 0;
+            for (; i + 4 <= n; i += 4)
+                _mm_storeu_ps(a + i, _mm_mul_ps(_mm_loadu_ps(a + i), factor));
+            ScaleScalar(a + i, c, n - i);
+        }
+        __attribute__((target("avx2"))) inline double SumSquaresAvx2(const float* a, int n) {
+            __m256d sum = _mm256_setzero_pd(), c = _mm256_setzero_pd();
+            int i = 0;
+            for (; i + 4 <= n; i += 4)
+                KahanStep(sum, c, _mm256_cvtps_pd(_mm_loadu_ps(a + i)));
+            return KahanReduce(sum, c) + SumSquaresScalar(a + i, n - i);
+        }
+        __attribute__((target("sse2"))) inline double SumSquaresSse2(const float* a, int n) {
+            __m128d sum = _mm_setzero_pd(), c = _mm_setzero_pd();
+            int i = 0;
+            for (; i + 4 <= n; i += 4) {
+                __m128 x = _mm_loadu_ps(a + i);
+                KahanStep(sum, c, _mm_cvtps_pd(x));
+                KahanStep(sum, c, _mm_cvtps_pd(_mm_movehl_ps(x, x)));
+            }
+            return KahanReduce(sum, c) + SumSquaresScalar(a + i, n - i);
+        }
+
+        // int, SSE2 has no 32-bit multiply so Scale stays scalar there
+
+        __attribute__((target("avx2"))) inline void AddAvx2(int* a, const int* b, int n) {
+            int i = 0;
+            for (; i + 8 <= n; i += 8) {
+                __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+                __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(a + i), _mm256_add_epi32(x, y));
+            }
+            AddScalar(a + i, b + i, n - i);
+        }
+        __attribute__((target("sse2"))) inline void AddSse2(int* a, const int* b, int n) {
+            int i = 0;
+            for (; i + 4 <= n; i += 4) {
+                __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+                __m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(a + i), _mm_add_epi32(x, y));
+            }
+            AddScalar(a + i, b + i, n - i);
+        }
+        __attribute__((target("avx2"))) inline void ScaleAvx2(int* a, int c, int n) {
+            __m256i factor = _mm256_set1_epi32(c);
+            int i = 0;
+            for (; i + 8 <= n; i += 8) {
+                __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(a + i), _mm256_mullo_epi32(x, factor));
+            }
+            ScaleScalar(a + i, c, n - i);
+        }
+        __attribute__((target("sse2"))) inline void ScaleSse2(int* a, int c, int n) {
+            ScaleScalar(a, c, n);
+        }
+        __attribute__((target("avx2"))) inline double SumSquaresAvx2(const int* a, int n) {
+            __m256d sum = _mm256_setzero_pd(), c = _mm256_setzero_pd();
+            int i = 0;
+            for (; i + 4 <= n; i += 4)
+                KahanStep(sum, c, _mm256_cvtepi32_pd(_mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i))));
+            return KahanReduce(sum, c) + SumSquaresScalar(a + i, n - i);
+        }
+        __attribute__((target("sse2"))) inline double SumSquaresSse2(const int* a, int n) {
+            __m128d sum = _mm_setzero_pd(), c = _mm_setzero_pd();
+            int i = 0;
+            for (; i + 4 <= n; i += 4) {
+                __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+                KahanStep(sum, c, _mm_cvtepi32_pd(x));
+                KahanStep(sum, c, _mm_cvtepi32_pd(_mm_shuffle_epi32(x, _MM_SHUFFLE(1, 0, 3, 2))));
+            }
+            return KahanReduce(sum, c) + SumSquaresScalar(a + i, n - i);
+        }
+
+        // Products for Triangle_Matrix::Multiply and Solve. Dot keeps two accumulators to hide the add latency
+
+        __attribute__((target("avx2"))) inline double DotAvx2(const double* a, const double* b, int n) {
+            __m256d s0 = _mm256_setzero_pd(), s1 = _mm256_setzero_pd();
+            int i = 0;
+            for (; i + 8 <= n; i += 8) {
+                s0 = _mm256_add_pd(s0, _mm256_mul_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i)));
+                s1 = _mm256_add_pd(s1, _mm256_mul_pd(_mm256_loadu_pd(a + i + 4), _mm256_loadu_pd(b + i + 4)));
+            }
+            alignas(32) double lanes[4];
+            _mm256_store_pd(lanes, _mm256_add_pd(s0, s1));
+            return lanes[0] + lanes[1] + lanes[2] + lanes[3] + DotScalar(a + i, b + i, n - i);
+        }
+        __attribute__((target("sse2"))) inline double DotSse2(const double* a, const double* b, int n) {
+            __m128d s0 = _mm_setzero_pd(), s1 = _mm_setzero_pd();
+            int i = 0;
+            for (; i + 4 <= n; i += 4) {
+                s0 = _mm_add_pd(s0, _mm_mul_pd(_mm_loadu_pd(a + i), _mm_loadu_pd(b + i)));
+                s1 = _mm_add_pd(s1, _mm_mul_pd(_mm_loadu_pd(a + i + 2), _mm_loadu_pd(b + i + 2)));
+            }
+            alignas(16) double lanes[2];
+            _mm_store_pd(lanes, _mm_add_pd(s0, s1));
+            return lanes[0] + lanes[1] + DotScalar(a + i, b + i, n - i);
+        }
+        __attribute__((target("avx2"))) inline void AxpyAvx2(double* y, double a, const double* x, int n) {
+            __m256d factor = _mm256_set1_pd(a);
+            int i = 0;
+            for (; i + 4 <= n; i += 4)
+                _mm256_storeu_pd(y + i, _mm256_add_pd(_mm256_loadu_pd(y + i), _mm256_mul_pd(factor, _mm256_loadu_pd(x + i))));
+            AxpyScalar(y + i, a, x + i, n - i);
+        }
+        __attribute__((target("sse2"))) inline void AxpySse2(double* y, double a, const double* x, int n) {
+            __m128d factor = _mm_set1_pd(a);
+            int i = 0;
+            for (; i + 2 <= n; i += 2)
+                _mm_storeu_pd(y + i, _mm_add_pd(_mm_loadu_pd(y + i), _mm_mul_pd(factor, _mm_loadu_pd(x + i))));
+            AxpyScalar(y + i, a, x + i, n - i);
+        }
+
+        __attribute__((target("avx2"))) inline float DotAvx2(const float* a, const float* b, int n) {
+            __m256 s0 = _mm256_setzero_ps(), s1 = _mm256_setzero_ps();
+            int i = 0;
+            for (; i + 16 <= n; i += 16) {
+                s0 = _mm256_add_ps(s0, _mm256_mul_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i)));
+                s1 = _mm256_add_ps(s1, _mm256_mul_ps(_mm256_loadu_ps(a + i + 8), _mm256_loadu_ps(b + i + 8)));
+            }
+            alignas(32) float lanes[8];
+            _mm256_store_ps(lanes, _mm256_add_ps(s0, s1));
+            float sum = DotScalar(a + i, b + i, n - i);
+            for (float lane : lanes)
+                sum += lane;
+            return sum;
+        }
+        __attribute__((target("sse2"))) inline float DotSse2(const float* a, const float* b, int n) {
+            __m128 s0 = _mm_setzero_ps(), s1 = _mm_setzero_ps();
+            int i = 0;
+            for (; i + 8 <= n; i += 8) {
+                s0 = _mm_add_ps(s0, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+                s1 = _mm_add_ps(s1, _mm_mul_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4)));
+            }
+            alignas(16) float lanes[4];
+            _mm_store_ps(lanes, _mm_add_ps(s0, s1));
+            return lanes[0] + lanes[1] + lanes[2] + lanes[3] + DotScalar(a + i, b + i, n - i);
+        }
+        __attribute__((target("avx2"))) inline void AxpyAvx2(float* y, float a, const float* x, int n) {
+            __m256 factor = _mm256_set1_ps(a);
+            int i = 0;
+            for (; i + 8 <= n; i += 8)
+                _mm256_storeu_ps(y + i, _mm256_add_ps(_mm256_loadu_ps(y + i), _mm256_mul_ps(factor, _mm256_loadu_ps(x + i))));
+            AxpyScalar(y + i, a, x + i, n - i);
+        }
+        __attribute__((target("sse2"))) inline void AxpySse2(float* y, float a, const float* x, int n) {
+            __m128 factor = _mm_set1_ps(a);
+            int i = 0;
+            for (; i + 4 <= n; i += 4)
+                _mm_storeu_ps(y + i, _mm_add_ps(_mm_loadu_ps(y + i), _mm_mul_ps(factor, _mm_loadu_ps(x + i))));
+            AxpyScalar(y + i, a, x + i, n - i);
+        }
+
+        __attribute__((target("avx2"))) inline int DotAvx2(const int* a, const int* b, int n) {
+            __m256i sum = _mm256_setzero_si256();
+            int i = 0;
+            for (; i + 8 <= n; i += 8) {
+                __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+                __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+                sum = _mm256_add_epi32(sum, _mm256_mullo_epi32(x, y));
+            }
+            alignas(32) int lanes[8];
+            _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), sum);
+            int total = DotScalar(a + i, b + i, n - i);
+            for (int lane : lanes)
+                total += lane;
+            return total;
+        }
+        __attribute__((target("sse2"))) inline int DotSse2(const int* a, const int* b, int n) {
+            return DotScalar(a, b, n);
+        }
+        __attribute__((target("avx2"))) inline void AxpyAvx2(int* y, int a, const int* x, int n) {
+            __m256i factor = _mm256_set1_epi32(a);
+            int i = 0;
+            for (; i + 8 <= n; i += 8) {
+                __m256i u = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(y + i));
+                __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(x + i));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(y + i), _mm256_add_epi32(u, _mm256_mullo_epi32(factor, v)));
+            }
+            AxpyScalar(y + i, a, x + i, n - i);
+        }
+        __attribute__((target("sse2"))) inline void AxpySse2(int* y, int a, const int* x, int n) {
+            AxpyScalar(y, a, x, n);
+        }
+
+        template <typename T>
+        struct HasVectorKernels : std::integral_constant<bool, std::is_same<T, double>::value || std::is_same<T, float>::value || std::is_same<T, int>::value> {};
+#else
+        template <typename T>
+        struct HasVectorKernels : std::false_type {};
+#endif
+
+        // a[i] += b[i]
+        template <typename T>
+        void Add(T* a, const T* b, int n) {
+#if LAB_KERNELS_X86
+            if constexpr (HasVectorKernels<T>::value) {
+                switch (GetLevel()) {
+                case Level::AVX2:
+                    return AddAvx2(a, b, n);
+                case Level::SSE2:
+                    return AddSse2(a, b, n);
+                default:
+                    break;
+                }
+            }
+#endif
+            AddScalar(a, b, n);
+        }
+
+        // a[i] *= c
+        template <typename T>
+        void Scale(T* a, T c, int n) {
+#if LAB_KERNELS_X86
+            if constexpr (HasVectorKernels<T>::value) {
+                switch (GetLevel()) {
+                case Level::AVX2:
+                    return ScaleAvx2(a, c, n);
+                case Level::SSE2:
+                    return ScaleSse2(a, c, n);
+                default:
+                    break;
+                }
+            }
+#endif
+            ScaleScalar(a, c, n);
+        }
+
+        // Sum of a[i]^2 accumulated in double
+        template <typename T>
+        double SumSquares(const T* a, int n) {
+#if LAB_KERNELS_X86
+            if constexpr (HasVectorKernels<T>::value) {
+                switch (GetLevel()) {
+                case Level::AVX2:
+                    return SumSquaresAvx2(a, n);
+                case Level::SSE2:
+                    return SumSquaresSse2(a, n);
+                default:
+                    break;
+                }
+            }
+#endif
+            return SumSquaresScalar(a, n);
+        }
+
+        // Sum of a[i] * b[i], accumulated in T
+        template <typename T>
+        T Dot(const T* a, const T* b, int n) {
+#if LAB_KERNELS_X86
+            if constexpr (HasVectorKernels<T>::value) {
+                switch (GetLevel()) {
+                case Level::AVX2:
+                    return DotAvx2(a, b, n);
+                case Level::SSE2:
+                    return DotSse2(a, b, n);
+                default:
+                    break;
+                }
+            }
+#endif
+            return DotScalar(a, b, n);
+        }
+
+        // y[i] += a * x[i]
+        template <typename T>
+        void Axpy(T* y, T a, const T* x, int n) {
+#if LAB_KERNELS_X86
+            if constexpr (HasVectorKernels<T>::value) {
+                switch (GetLevel()) {
+                case Level::AVX2:
+                    return AxpyAvx2(y, a, x, n);
+                case Level::SSE2:
+                    return AxpySse2(y, a, x, n);
+                default:
+                    break;
+                }
+            }
+#endif
+            AxpyScalar(y, a, x, n);
+        }
+    }
+}
\ No newline at end of file
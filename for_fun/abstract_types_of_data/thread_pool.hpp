@@ -0,0 +1,158 @@
+namespace Lab {
+    // Fixed set of workers, each with its own task deque. A worker pops its newest task first and
+    // steals the oldest task of another worker when its own deque runs dry. The thread calling
+    // ParallelFor works too, so a pool of n threads starts n - 1 workers.
+    class ThreadPool {
+        struct Queue {
+            std::mutex mutex;
+            std::deque<std::function<void()>> tasks;
+        };
+
+        std::vector<std::unique_ptr<Queue>> queues;
+        std::vector<std::thread> workers;
+        std::mutex sleepMutex;
+        std::condition_variable wake;
+        std::atomic<int> pending{0};
+        bool stopping = false;
+
+        // Built by the first caller, the initialization of a local static is thread-safe
+        static std::unique_ptr<ThreadPool>& DefaultSlot() {
+            static std::unique_ptr<ThreadPool> pool = std::make_unique<ThreadPool>();
+            return pool;
+        }
+
+        bool PopOwn(std::size_t index, std::function<void()>& task) {
+            Queue& queue = *queues[index];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            if (queue.tasks.empty())
+                return false;
+            task = std::move(queue.tasks.back());
+            queue.tasks.pop_back();
+            --pending;
+            return true;
+        }
+
+        bool Steal(std::size_t thief, std::function<void()>& task) {
+            for (std::size_t k = 1; k <= queues.size(); ++k) {
+                Queue& queue = *queues[(thief + k) % queues.size()];
+                std::lock_guard<std::mutex> lock(queue.mutex);
+                if (!queue.tasks.empty()) {
+                    task = std::move(queue.tasks.front());
+                    queue.tasks.pop_front();
+                    --pending;
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        void Work(std::size_t index) {
+            std::function<void()> task;
+            for (;;) {
+                if (PopOwn(index, task) || Steal(index, task)) {
+                    task();
+                    continue;
+                }
+                std::unique_lock<std::mutex> lock(sleepMutex);
+                wake.wait(lock, [this] { return stopping || pending > 0; });
+                if (stopping && pending == 0)
+                    return;
+            }
+        }
+    public:
+        // threads <= 0 takes one thread per hardware core
+        explicit ThreadPool(int threads = 0) {
+            if (threads <= 0)
+                threads = std::max(1u, std::thread::hardware_concurrency());
+            for (int i = 1; i < threads; ++i)
+                queues.push_back(std::make_unique<Queue>());
+            for (std::size_t i = 0; i < queues.size(); ++i)
+                workers.emplace_back(&ThreadPool::Work, this, i);
+        }
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+        ~ThreadPool() {
+            {
+                std::lock_guard<std::mutex> lock(sleepMutex);
+                stopping = true;
+            }
+            wake.notify_all();
+            for (std::thread& worker : workers)
+                worker.join();
+        }
+
+        int GetThreadCount() const {
+            return static_cast<int>(workers.size()) + 1;
+        }
+
+        // Pool shared by the library. Pinning the count replaces it, so don't call that while it is busy
+        static ThreadPool& Default() {
+            return *DefaultSlot();
+        }
+        static void SetDefaultThreads(int threads) {
+            DefaultSlot() = std::make_unique<ThreadPool>(threads);
+        }
+
+        // How many chunks of at least grain items count splits into, a few per thread so
+        // that stealing can even out chunks that turn out slower
+        int Chunks(long long count, long long grain) const {
+            long long chunks = std::min<long long>(count / std::max(1LL, grain), 4LL * GetThreadCount());
+            return static_cast<int>(std::max(1LL, chunks));
+        }
+
+        // Splits [0, count) into chunks equal parts and calls f(chunk, begin, end) on each. Returns when
+        // all of them are done, the first exception thrown by f is rethrown here
+        template <typename F>
+        void ParallelFor(long long count, int chunks, F f) {
+            if (count <= 0)
+                return;
+            chunks = static_cast<int>(std::max(1LL, std::min<long long>(chunks, count)));
+            auto bounds = [count, chunks](int chunk) { return count * chunk / chunks; };
+            if (chunks == 1 || queues.empty()) {
+                for (int chunk = 0; chunk < chunks; ++chunk)
+                    f(chunk, bounds(chunk), bounds(chunk + 1));
+                return;
+            }
+
+            struct Batch {
+                std::atomic<int> remaining;
+                std::mutex mutex;
+                std::condition_variable done;
+                std::exception_ptr error;
+            } batch;
+            batch.remaining = chunks;
+
+            for (int chunk = 0; chunk < chunks; ++chunk) {
+                Queue& queue = *queues[chunk % queues.size()];
+                std::lock_guard<std::mutex> lock(queue.mutex);
+                queue.tasks.emplace_back([&batch, &f, &bounds, chunk] {
+                    std::exception_ptr error;
+                    try {
+                        f(chunk, bounds(chunk), bounds(chunk + 1));
+                    } catch (...) {
+                        error = std::current_exception();
+                    }
+                    // Counted down under the lock, the waiter may destroy batch as soon as it sees zero
+                    std::lock_guard<std::mutex> lock(batch.mutex);
+                    if (error && !batch.error)
+                        batch.error = error;
+                    if (--batch.remaining == 0)
+                        batch.done.notify_all();
+                });
+                ++pending;
+            }
+            {
+                std::lock_guard<std::mutex> lock(sleepMutex);
+            }
+            wake.notify_all();
+
+            std::function<void()> task;
+            while (batch.remaining > 0 && Steal(0, task))
+                task();
+            std::unique_lock<std::mutex> lock(batch.mutex);
+            batch.done.wait(lock, [&batch] { return batch.remaining == 0; });
+            if (batch.error)
+                std::rethrow_exception(batch.error);
+        }
+    };
+}
@@ -0,0 +1,115 @@
+namespace Lab {
+    template <typename T, template <typename> class Storage, typename Check>
+    class Triangle_Matrix;
+
+    // Lazy element-wise arithmetic over triangle matrices of one shape. The operators only build a tree,
+    // assigning it to a Triangle_Matrix evaluates it cell by cell in one pass over the stored triangle.
+    // Every node provides GetSize(), GetIsUpper() and At(k), the k-th stored cell in row-major order
+    template <typename E>
+    class TriangleExpression {
+    public:
+        const E& Self() const {
+            return static_cast<const E&>(*this);
+        }
+    };
+
+    // Matrices are held by reference, inner nodes by value so that temporaries can be nested
+    template <typename E>
+    struct TriangleOperand {
+        using type = const E;
+    };
+    template <typename T, template <typename> class Storage, typename Check>
+    struct TriangleOperand<Triangle_Matrix<T, Storage, Check>> {
+        using type = const Triangle_Matrix<T, Storage, Check>&;
+    };
+
+    template <typename L, typename R, typename Op>
+    class TriangleBinary : public TriangleExpression<TriangleBinary<L, R, Op>> {
+        typename TriangleOperand<L>::type left;
+        typename TriangleOperand<R>::type right;
+    public:
+        using value_type = typename L::value_type;
+
+        TriangleBinary(const L& left, const R& right) : left(left), right(right) {
+            if (left.GetSize() != right.GetSize())
+                throw Lab::DifferentSizes("Matrices have different sizes");
+            if (left.GetIsUpper() ^ right.GetIsUpper())
+                throw Lab::UpperAndLower("Triangle matrices are upper and lower");
+        }
+
+        int GetSize() const {
+            return left.GetSize();
+        }
+        bool GetIsUpper() const {
+            return left.GetIsUpper();
+        }
+        value_type At(int k) const {
+            return Op()(left.At(k), right.At(k));
+        }
+    };
+
+    template <typename E>
+    class TriangleScaled : public TriangleExpression<TriangleScaled<E>> {
+    public:
+        using value_type = typename E::value_type;
+    private:
+        typename TriangleOperand<E>::type operand;
+        value_type c;
+    public:
+        TriangleScaled(const E& operand, value_type c) : operand(operand), c(c) {}
+
+        int GetSize() const {
+            return operand.GetSize();
+        }
+        bool GetIsUpper() const {
+            return operand.GetIsUpper();
+        }
+        value_type At(int k) const {
+            return operand.At(k) * c;
+        }
+    };
+
+    template <typename E>
+    class TriangleNegated : public TriangleExpression<TriangleNegated<E>> {
+        typename TriangleOperand<E>::type operand;
+    public:
+        using value_type = typename E::value_type;
+
+        explicit TriangleNegated(const E& operand) : operand(operand) {}
+
+        int GetSize() const {
+            return operand.GetSize();
+        }
+        bool GetIsUpper() const {
+            return operand.GetIsUpper();
+        }
+        value_type At(int k) const {
+            return -operand.At(k);
+        }
+    };
+
+    template <typename L, typename R>
+    TriangleBinary<L, R, std::plus<typename L::value_type>> operator+(const TriangleExpression<L>& left, const TriangleExpression<R>& right) {
+        return TriangleBinary<L, R, std::plus<typename L::value_type>>(left.Self(), right.Self());
+    }
+
+    template <typename L, typename R>
+    TriangleBinary<L, R, std::minus<typename L::value_type>> operator-(const TriangleExpression<L>& left, const TriangleExpression<R>& right) {
+        return TriangleBinary<L, R, std::minus<typename L::value_type>>(left.Self(), right.Self());
+    }
+
+    template <typename E>
+    TriangleNegated<E> operator-(const TriangleExpression<E>& operand) {
+        return TriangleNegated<E>(operand.Self());
+    }
+
+    template <typename E>
+    TriangleScaled<E> operator*(const TriangleExpression<E>& operand, typename E::value_type c) {
+        return TriangleScaled<E>(operand.Self(), c);
+    }
+
+    template <typename E>
+    TriangleScaled<E> operator*(typename E::value_type c, const TriangleExpression<E>& operand) {
+        return TriangleScaled<E>(operand.Self(), c);
+    }
+}
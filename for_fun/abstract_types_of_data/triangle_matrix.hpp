@@ -1,37 +1,238 @@
 namespace Lab {
-    template <typename T>
-    class Triangle_Matrix {
+    template <typename T, template <typename> class Storage = Lab::PackedTriangleStorage, typename Check = Lab::Checked>
+    class Triangle_Matrix : public TriangleExpression<Triangle_Matrix<T, Storage, Check>> {
     private:
         int size = 0;
         bool upper = 0;
-        Lab::Sequence<Lab::Sequence<T>*>* TrMat;
-    public:
-        Triangle_Matrix(int size, bool upper) : size(size), upper(upper) {
+        Storage<T> TrMat;
+
+        static int CheckedSize(int size) {
             if (size < 0)
                 throw std::logic_error("Negative size");
-            TrMat = (Lab::Sequence<Lab::Sequence<T>*>*) new Lab::ListSequence<Lab::ListSequence<T>*>;
-            for (int i = 0; i < size; i++)
-                TrMat->Append(new Lab::ListSequence<T>(size));
+            return size;
+        }
+
+        // Tile sizes of the matrix product: a KBlock x JBlock panel of B stays in cache while every row of A goes over it
+        static constexpr int KBlock = 64;
+        static constexpr int JBlock = 512;
+
+        // The product kernels work on flat rows, list storage is copied into a packed buffer first
+        PackedTriangleStorage<T> Packed() const {
+            PackedTriangleStorage<T> packed(size, upper);
+            T* cell = packed.Data();
+            TrMat.ForEachStored([&](const T& item) { *cell++ = item; });
+            return packed;
+        }
+
+        // Smallest run of cells worth handing to another thread
+        static constexpr long long ParallelGrain = 1 << 15;
+
+        // Replaces the cells with those of a packed triangle of the same shape
+        void Assign(PackedTriangleStorage<T>&& dense) {
+            if constexpr (std::is_same<Storage<T>, PackedTriangleStorage<T>>::value) {
+                TrMat = std::move(dense);
+            } else if constexpr (Storage<T>::sparse) {
+                TrMat = Storage<T>(dense);
+            } else {
+                const T* cell = dense.Data();
+                TrMat.ForEachStored([&](T& item) { item = *cell++; });
+            }
+        }
+
+        // Splits rows into contiguous ranges of about equal cost and runs body(begin, end) on each
+        // over the default pool. parts <= 0 takes one range per pool thread
+        template <typename Cost, typename F>
+        void ForRowRanges(int parts, Cost cost, F body) const {
+            Lab::ThreadPool& pool = Lab::ThreadPool::Default();
+            if (parts <= 0)
+                parts = pool.GetThreadCount();
+            parts = std::max(1, std::min(parts, size));
+            if (parts == 1) {
+                body(0, size);
+                return;
+            }
+            double total = 0;
+            for (int i = 0; i < size; ++i)
+                total += cost(i);
+            std::vector<int> bounds(parts + 1, size);
+            bounds[0] = 0;
+            double done = 0;
+            for (int part = 1, end = 0; part < parts; ++part) {
+                while (end < size && done < total * part / parts)
+                    done += cost(end++);
+                bounds[part] = end;
+            }
+            pool.ParallelFor(parts, parts, [&](int part, long long, long long) {
+                body(bounds[part], bounds[part + 1]);
+            });
+        }
+
+        // Runs f(begin, end) over runs of packed cells on the default pool. Cells cost the same whatever
+        // row they are in, so equal runs of cells balance where equal runs of rows would not
+        template <typename F>
+        void ForStoredRanges(F f) const {
+            Lab::ThreadPool& pool = Lab::ThreadPool::Default();
+            long long count = TrMat.StoredCount();
+            pool.ParallelFor(count, pool.Chunks(count, ParallelGrain), [&](int, long long begin, long long end) {
+                f(static_cast<int>(begin), static_cast<int>(end - begin));
+            });
+        }
+
+        template <typename Rows>
+        void MultiplyRows(const Rows& a, const T* x, T* y, int threads) const {
+            ForRowRanges(threads, [&](int i) { return double(a.RowLength(i)); }, [&](int begin, int end) {
+                for (int i = begin; i < end; ++i)
+                    y[i] = Lab::Kernels::Dot(a.Row(i), x + a.RowBegin(i), a.RowLength(i));
+            });
+        }
+
+        // c += a * b row by row: row i of c gathers a[i][k] * (row k of b) for every stored k,
+        // cells outside the triangles are never visited
+        template <typename RowsA, typename RowsB, typename RowsC>
+        void MultiplyBlocked(const RowsA& a, const RowsB& b, RowsC& c, int threads) const {
+            auto cost = [&](int i) {
+                double length = a.RowLength(i);
+                return length * (length + 1) / 2;
+            };
+            ForRowRanges(threads, cost, [&](int begin, int end) {
+                if (upper) {
+                    // c[i][j] = sum of a[i][k] * b[k][j] for i <= k <= j
+                    for (int jb = begin; jb < size; jb += JBlock) {
+                        int jend = std::min(size, jb + JBlock);
+                        for (int kb = begin; kb < jend; kb += KBlock) {
+                            int kend = std::min(jend, kb + KBlock);
+                            for (int i = begin; i < end && i < kend; ++i) {
+                                const T* arow = a.Row(i);
+                                T* crow = c.Row(i);
+                                for (int k = std::max(i, kb); k < kend; ++k) {
+                                    int j = std::max(k, jb);
+                                    Lab::Kernels::Axpy(crow + (j - i), arow[k - i], b.Row(k) + (j - k), jend - j);
+                                }
+                            }
+                        }
+                    }
+                } else {
+                    // c[i][j] = sum of a[i][k] * b[k][j] for j <= k <= i
+                    for (int jb = 0; jb < end; jb += JBlock) {
+                        int jend = std::min(end, jb + JBlock);
+                        for (int kb = jb; kb < end; kb += KBlock) {
+                            int kend = std::min(end, kb + KBlock);
+                            for (int i = std::max(begin, kb); i < end; ++i) {
+                                const T* arow = a.Row(i);
+                                T* crow = c.Row(i);
+                                for (int k = kb, klast = std::min(kend, i + 1); k < klast; ++k)
+                                    Lab::Kernels::Axpy(crow + jb, arow[k], b.Row(k) + jb, std::min(jend, k + 1) - jb);
+                            }
+                        }
+                    }
+                }
+            });
+        }
+
+        // Back substitution for upper matrices, forward for lower ones. x holds b on entry
+        template <typename Rows>
+        void Substitute(const Rows& a, T* x) const {
+            for (int step = 0; step < size; ++step) {
+                int i = upper ? size - 1 - step : step;
+                const T* row = a.Row(i);
+                T diagonal = row[i - a.RowBegin(i)];
+                if (diagonal == T())
+                    throw Lab::Singular("Triangle matrix is singular, zero on the diagonal in row " + std::to_string(i));
+                T solved = upper ? Lab::Kernels::Dot(row + 1, x + i + 1, size - i - 1) : Lab::Kernels::Dot(row, x, i);
+                x[i] = (x[i] - solved) / diagonal;
+            }
+        }
+
+        // Writes every stored cell of the expression in one pass over the pool. Each cell reads only the
+        // same cell of its operands, so the expression may refer to this matrix itself
+        template <typename E>
+        void Evaluate(const E& expression) {
+            static_assert(Storage<T>::contiguous, "Triangle expressions are evaluated over packed storage");
+            ForStoredRanges([&](int begin, int count) {
+                T* cell = TrMat.Data() + begin;
+                for (int k = 0; k < count; ++k)
+                    cell[k] = expression.At(begin + k);
+            });
+        }
+    public:
+        using value_type = T;
+
+        Triangle_Matrix(int size, bool upper) : size(size), upper(upper), TrMat(CheckedSize(size), upper) {}
+        explicit Triangle_Matrix(Storage<T>&& storage) : size(storage.GetSize()), upper(storage.GetIsUpper()), TrMat(std::move(storage)) {}
+
+        // Converts between storages, e.g. dense to sparse and back
+        template <template <typename> class Other, typename OtherCheck>
+        explicit Triangle_Matrix(const Triangle_Matrix<T, Other, OtherCheck>& other) : Triangle_Matrix(other.GetSize(), other.GetIsUpper()) {
+            PackedTriangleStorage<T> dense(this->size, this->upper);
+            T* cell = dense.Data();
+            other.ForEachStored([&](const T& item) { *cell++ = item; });
+            Assign(std::move(dense));
+        }
+
+        template <typename E>
+        Triangle_Matrix(const TriangleExpression<E>& expression) : Triangle_Matrix(expression.Self().GetSize(), expression.Self().GetIsUpper()) {
+            Evaluate(expression.Self());
+        }
+
+        template <typename E>
+        Triangle_Matrix& operator=(const TriangleExpression<E>& expression) {
+            const E& e = expression.Self();
+            if (this->size != e.GetSize() || this->upper != e.GetIsUpper()) {
+                this->size = e.GetSize();
+                this->upper = e.GetIsUpper();
+                this->TrMat = Storage<T>(this->size, this->upper);
+            }
+            Evaluate(e);
+            return *this;
+        }
+
+        // k-th stored cell in row-major order, this is how expressions read a matrix
+        T At(int k) const {
+            static_assert(Storage<T>::contiguous, "Triangle expressions are evaluated over packed storage");
+            return TrMat.Data()[k];
         }
         
         T Get(int i, int j) const {
-            if (i < 0 || i >= this->size || j < 0 || j >= this->size) 
-                throw Lab::IndexOutOfRange("Trying to get element with wrong indices");
-            return TrMat->Get(i)->Get(j);
+            if constexpr (Check::enabled)
+                if (!Lab::InRange(i, this->size) || !Lab::InRange(j, this->size))
+                    Lab::ThrowIndexOutOfRange("Trying to get element with wrong indices");
+            return TrMat.Get(i, j);
         }
 
-        void Fill(T item) {
-            if (upper) {
-                for (int i = 0; i < this->size; i++)
-                    for (int j = 0; j < this->size; j++)
-                        if (i <= j)
-                            this->Set(item, i, j);
-            } else {
-                for (int i = 0; i < this->size; i++)
-                    for (int j = 0; j < this->size; j++)
-                        if (i >= j)
-                            this->Set(item, i, j);
+        // Reference to a cell of the triangle, packed storage only. Reading a cell outside the
+        // triangle gives a zero, writing to one throws like Set does
+        T& operator()(int i, int j) {
+            static_assert(Storage<T>::contiguous, "Only packed storage hands out references to cells");
+            if constexpr (Check::enabled) {
+                if (!Lab::InRange(i, this->size) || !Lab::InRange(j, this->size))
+                    Lab::ThrowIndexOutOfRange("Trying to get element with wrong indices");
+                if (!TrMat.InTriangle(i, j))
+                    Lab::ThrowLogicError("Trying to reference a cell outside of the triangle");
             }
+            return TrMat.Data()[TrMat.Index(i, j)];
+        }
+        const T& operator()(int i, int j) const {
+            static_assert(Storage<T>::contiguous, "Only packed storage hands out references to cells");
+            static const T zero = T();
+            if constexpr (Check::enabled)
+                if (!Lab::InRange(i, this->size) || !Lab::InRange(j, this->size))
+                    Lab::ThrowIndexOutOfRange("Trying to get element with wrong indices");
+            return TrMat.InTriangle(i, j) ? TrMat.Data()[TrMat.Index(i, j)] : zero;
+        }
+
+        // Visits the stored cells in row-major order
+        template <typename F>
+        void ForEachStored(F f) const {
+            TrMat.ForEachStored(f);
+        }
+
+        void Fill(T item) {
+            if constexpr (Storage<T>::contiguous)
+                ForStoredRanges([&](int begin, int count) { std::fill_n(TrMat.Data() + begin, count, item); });
+            else if constexpr (Storage<T>::sparse)
+                TrMat.Fill(item);
+            else
+                TrMat.ForEachStored([&](T& cell) { cell = item; });
         }
 
         bool wrong (int i, int j, const T &item) const {
@@ -50,20 +251,22 @@ namespace Lab {
         }
 
         void Set(T item, int i, int j) {
-            if (item != T()) {
-                if (upper) {
-                    if (i > j) {
-                        throw std::logic_error("Trying to set element of upper triangle matrix where i > j");
-                    }
-                } else {
-                    if (i < j) {
-                        throw std::logic_error("Trying to set element of lower triangle matrix where i < j");
+            if constexpr (Check::enabled) {
+                if (item != T()) {
+                    if (upper) {
+                        if (i > j) {
+                            Lab::ThrowLogicError("Trying to set element of upper triangle matrix where i > j");
+                        }
+                    } else {
+                        if (i < j) {
+                            Lab::ThrowLogicError("Trying to set element of lower triangle matrix where i < j");
+                        }
                     }
                 }
+                if (!Lab::InRange(i, this->size) || !Lab::InRange(j, this->size))
+                    Lab::ThrowIndexOutOfRange("Trying to set element with wrong indices");
             }
-            if (i < 0 || i >= this->size || j < 0 || j >= this->size)  
-                throw Lab::IndexOutOfRange("Trying to set element with wrong indices");
-            this->TrMat->Get(i)->Set(item, j);
+            this->TrMat.Set(item, i, j);
         }
 
         int GetSize() const {
@@ -74,40 +277,118 @@ namespace Lab {
             return this->upper;
         }
 
+        // Cells actually kept by sparse storage
+        int NonZeroCount() const {
+            static_assert(Storage<T>::sparse, "Only sparse storage counts its nonzero cells");
+            return TrMat.NonZeroCount();
+        }
+
         double GetNorme() const {
-            T sum = 0;
-            for (int i = 0; i < this->size; i++)
-                for (int j = 0; j < this->size; j++)
-                    sum += (this->Get(i, j)) * (this->Get(i, j));
-            return std::sqrt(sum);
+            if constexpr (Storage<T>::contiguous) {
+                // One partial sum per chunk, added in chunk order so the result doesn't depend on scheduling
+                Lab::ThreadPool& pool = Lab::ThreadPool::Default();
+                long long count = TrMat.StoredCount();
+                std::vector<double> partial(pool.Chunks(count, ParallelGrain), 0.0);
+                pool.ParallelFor(count, static_cast<int>(partial.size()), [&](int chunk, long long begin, long long end) {
+                    partial[chunk] = Lab::Kernels::SumSquares(TrMat.Data() + begin, static_cast<int>(end - begin));
+                });
+                Lab::Kernels::KahanSum sum;
+                for (double part : partial)
+                    sum.Add(part);
+                return std::sqrt(sum.sum);
+            } else if constexpr (Storage<T>::sparse) {
+                return std::sqrt(TrMat.SumSquares());
+            } else {
+                Lab::Kernels::KahanSum sum;
+                TrMat.ForEachStored([&](const T& cell) { sum.Add(static_cast<double>(cell) * static_cast<double>(cell)); });
+                return std::sqrt(sum.sum);
+            }
         }
         
-        Triangle_Matrix<T>* Sum(Triangle_Matrix<T>* B) {
+        Triangle_Matrix* Sum(Triangle_Matrix* B) {
             if (this->size != B->size)
                 throw Lab::DifferentSizes("Matrices have different sizes");
             if (this->upper ^ B->upper) {
                 throw Lab::UpperAndLower("Triangle matrices are upper and lower");
             } 
 
-            for (int i = 0; i < this->size; i++)
-                for (int j = 0; j < this->size; j++)
-                    this->Set(this->Get(i, j) + B->Get(i, j), i, j);
+            if constexpr (Storage<T>::contiguous)
+                ForStoredRanges([&](int begin, int count) { Lab::Kernels::Add(TrMat.Data() + begin, B->TrMat.Data() + begin, count); });
+            else if constexpr (Storage<T>::sparse)
+                TrMat.Add(B->TrMat);
+            else
+                TrMat.Zip(B->TrMat, [](T& item, const T& other) { item = item + other; });
             return this;
         }
 
-        Triangle_Matrix<T>* Scalar(T c) {
-            for (int i = 0; i < this->size; i++)
-                for (int j = 0; j < this->size; j++)
-                    this->Set(this->Get(i, j) * c, i, j);
+        Triangle_Matrix* Scalar(T c) {
+            if constexpr (Storage<T>::contiguous)
+                ForStoredRanges([&](int begin, int count) { Lab::Kernels::Scale(TrMat.Data() + begin, c, count); });
+            else if constexpr (Storage<T>::sparse)
+                TrMat.Scale(c);
+            else
+                TrMat.ForEachStored([&](T& item) { item = item * c; });
             return this;
         }
 
-        void Print() const {
-            for (int i = 0; i < this->GetSize(); i++) {
-                for (int j = 0; j < this->GetSize(); j++)
-                    std::cout << std::setiosflags(std::ios::left)  << std::setw(5) << this->Get(i, j) << " ";
-                std::cout << std::endl;
+        // y = A * x. The rows are split into threads parts on the default pool, 0 means one per pool thread
+        Lab::ArraySequence<T>* Multiply(const Lab::Sequence<T>& x, int threads = 0) const {
+            if (x.GetSize() != this->size)
+                throw Lab::DifferentSizes("Vector length differs from the matrix size");
+            DynamicArray<T> items(this->size);
+            std::copy(x.begin(), x.end(), items.begin());
+            // Owned here until returned, so a throwing kernel or element operation doesn't leak it
+            std::unique_ptr<Lab::ArraySequence<T>> y(new Lab::ArraySequence<T>(this->size));
+            if constexpr (Storage<T>::contiguous)
+                MultiplyRows(TrMat, items.begin(), y->begin(), threads);
+            else if constexpr (Storage<T>::sparse)
+                TrMat.MultiplyVector(items.begin(), y->begin());
+            else
+                MultiplyRows(Packed(), items.begin(), y->begin(), threads);
+            return y.release();
+        }
+
+        // A * B is triangular only when both are upper or both are lower
+        Triangle_Matrix* Multiply(const Triangle_Matrix* B, int threads = 0) const {
+            if (this->size != B->size)
+                throw Lab::DifferentSizes("Matrices have different sizes");
+            if (this->upper ^ B->upper)
+                throw Lab::UpperAndLower("Product of upper and lower triangle matrices is not triangular");
+
+            std::unique_ptr<Triangle_Matrix> C(new Triangle_Matrix(this->size, this->upper));
+            if constexpr (Storage<T>::contiguous) {
+                MultiplyBlocked(TrMat, B->TrMat, C->TrMat, threads);
+            } else if constexpr (Storage<T>::sparse) {
+                C->TrMat = TrMat.Multiply(B->TrMat);
+            } else {
+                PackedTriangleStorage<T> product(this->size, this->upper);
+                MultiplyBlocked(Packed(), B->Packed(), product, threads);
+                C->Assign(std::move(product));
             }
+            return C.release();
+        }
+
+        // Solves A * x = b, throws Lab::Singular if the diagonal has a zero
+        Lab::ArraySequence<T>* Solve(const Lab::Sequence<T>& b) const {
+            if (b.GetSize() != this->size)
+                throw Lab::DifferentSizes("Right-hand side length differs from the matrix size");
+            std::unique_ptr<Lab::ArraySequence<T>> x(new Lab::ArraySequence<T>(this->size));
+            std::copy(b.begin(), b.end(), x->begin());
+            if constexpr (Storage<T>::contiguous)
+                Substitute(TrMat, x->begin());
+            else if constexpr (Storage<T>::sparse)
+                TrMat.Solve(x->begin());
+            else
+                Substitute(Packed(), x->begin());
+            return x.release();
+        }
+
+        void Print() const {
+            TrMat.ForEachCell([&](int /*i*/, int j, const T& item) {
+                std::cout << std::setiosflags(std::ios::left)  << std::setw(5) << item << " ";
+                if (j == this->size - 1)
+                    std::cout << std::endl;
+            });
         }
     };
 }
\ No newline at end of file
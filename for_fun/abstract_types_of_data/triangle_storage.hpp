@@ -0,0 +1,411 @@
+namespace Lab {
+    // Storage policies for Triangle_Matrix. Both keep only the cells of the triangle meaningful
+    // and walk them in row-major order, cells outside of it always read as T().
+
+    // All n(n+1)/2 cells of the triangle in one buffer, row after row
+    template <typename T>
+    class PackedTriangleStorage {
+        int size = 0;
+        bool upper = false;
+        DynamicArray<T> data;
+
+        static int PackedSize(int size) {
+            long long count = (long long)size * (size + 1) / 2;
+            if (count > std::numeric_limits<int>::max())
+                throw std::logic_error("Triangle matrix is too large: " + std::to_string(size));
+            return static_cast<int>(count);
+        }
+    public:
+        static constexpr bool contiguous = true;
+        static constexpr bool sparse = false;
+
+        PackedTriangleStorage(int size, bool upper) : size(size), upper(upper), data(PackedSize(size)) {}
+        // Takes the cells as they are, e.g. borrowed from a mapped file
+        PackedTriangleStorage(int size, bool upper, DynamicArray<T>&& cells) : size(size), upper(upper), data(std::move(cells)) {
+            if (data.GetSize() != PackedSize(size))
+                throw Lab::DifferentSizes("Packed triangle of size " + std::to_string(size) + " needs " + std::to_string(PackedSize(size)) + " cells, got " + std::to_string(data.GetSize()));
+        }
+
+        int GetSize() const {
+            return size;
+        }
+        bool GetIsUpper() const {
+            return upper;
+        }
+
+        bool InTriangle(int i, int j) const {
+            return upper ? i <= j : i >= j;
+        }
+        // First stored column of row i and how many cells of it are stored
+        int RowBegin(int i) const {
+            return upper ? i : 0;
+        }
+        int RowLength(int i) const {
+            return upper ? size - i : i + 1;
+        }
+        int RowOffset(int i) const {
+            long long row = i;
+            return static_cast<int>(upper ? row * size - row * (row - 1) / 2 : row * (row + 1) / 2);
+        }
+        int Index(int i, int j) const {
+            return RowOffset(i) + j - RowBegin(i);
+        }
+        T* Row(int i) {
+            return Data() + RowOffset(i);
+        }
+        const T* Row(int i) const {
+            return Data() + RowOffset(i);
+        }
+        T* Data() {
+            return data.begin();
+        }
+        const T* Data() const {
+            return data.begin();
+        }
+        int StoredCount() const {
+            return data.GetSize();
+        }
+
+        T Get(int i, int j) const {
+            return InTriangle(i, j) ? Data()[Index(i, j)] : T();
+        }
+        void Set(const T& item, int i, int j) {
+            if (InTriangle(i, j))
+                Data()[Index(i, j)] = item;
+        }
+
+        template <typename F>
+        void ForEachStored(F f) {
+            for (T& item : data)
+                f(item);
+        }
+        template <typename F>
+        void ForEachStored(F f) const {
+            for (const T& item : data)
+                f(item);
+        }
+        template <typename F>
+        void Zip(const PackedTriangleStorage<T>& other, F f) {
+            T* mine = Data();
+            const T* theirs = other.Data();
+            for (int k = 0, n = StoredCount(); k < n; ++k)
+                f(mine[k], theirs[k]);
+        }
+        template <typename F>
+        void ForEachCell(F f) const {
+            const T zero = T();
+            const T* cell = Data();
+            for (int i = 0; i < size; ++i)
+                for (int j = 0; j < size; ++j)
+                    f(i, j, InTriangle(i, j) ? *cell++ : zero);
+        }
+    };
+
+    // The original layout: a list of full-width list rows. Kept for callers that grow rows in place
+    template <typename T>
+    class ListTriangleStorage {
+        int size = 0;
+        bool upper = false;
+        Lab::ListSequence<Lab::ListSequence<T>> rows;
+    public:
+        static constexpr bool contiguous = false;
+        static constexpr bool sparse = false;
+
+        ListTriangleStorage(int size, bool upper) : size(size), upper(upper) {
+            for (int i = 0; i < size; i++)
+                rows.Emplace(size);
+        }
+
+        int GetSize() const {
+            return size;
+        }
+        bool GetIsUpper() const {
+            return upper;
+        }
+
+        bool InTriangle(int i, int j) const {
+            return upper ? i <= j : i >= j;
+        }
+
+        T Get(int i, int j) const {
+            auto row = rows.cbegin();
+            std::advance(row, i);
+            auto item = row->cbegin();
+            std::advance(item, j);
+            return *item;
+        }
+        void Set(const T& item, int i, int j) {
+            auto row = rows.begin();
+            std::advance(row, i);
+            row->Set(item, j);
+        }
+
+        template <typename F>
+        void ForEachStored(F f) {
+            int i = 0;
+            for (Lab::ListSequence<T>& row : rows) {
+                int j = 0;
+                for (T& item : row)
+                    if (InTriangle(i, j++))
+                        f(item);
+                ++i;
+            }
+        }
+        template <typename F>
+        void ForEachStored(F f) const {
+            ForEachCell([&](int i, int j, const T& item) {
+                if (InTriangle(i, j))
+                    f(item);
+            });
+        }
+        template <typename F>
+        void Zip(const ListTriangleStorage<T>& other, F f) {
+            auto theirs = other.rows.cbegin();
+            int i = 0;
+            for (Lab::ListSequence<T>& row : rows) {
+                auto cell = theirs->cbegin();
+                int j = 0;
+                for (T& item : row) {
+                    if (InTriangle(i, j++))
+                        f(item, *cell);
+                    ++cell;
+                }
+                ++theirs;
+                ++i;
+            }
+        }
+        template <typename F>
+        void ForEachCell(F f) const {
+            int i = 0;
+            for (auto row = rows.cbegin(); row != rows.cend(); ++row, ++i) {
+                int j = 0;
+                for (auto item = row->cbegin(); item != row->cend(); ++item)
+                    f(i, j++, *item);
+            }
+        }
+    };
+
+    // Compressed sparse rows: only the nonzero cells of the triangle, row after row with sorted columns.
+    // Get is a binary search within the row, the arithmetic below costs O(nnz) rather than O(n^2).
+    // Set on a new position shifts the cells after it, so build large matrices from dense or in row order
+    template <typename T>
+    class CsrTriangleStorage {
+        int size = 0;
+        bool upper = false;
+        DynamicArray<int> rowStart;     // row i is [rowStart[i], rowStart[i + 1]) of columns and values
+        DynamicArray<int> columns;
+        DynamicArray<T> values;
+
+        int Find(int i, int j) const {
+            const int* first = columns.begin() + rowStart.begin()[i];
+            const int* last = columns.begin() + rowStart.begin()[i + 1];
+            const int* cell = std::lower_bound(first, last, j);
+            return cell != last && *cell == j ? static_cast<int>(cell - columns.begin()) : -1;
+        }
+        void Clear() {
+            columns.Resize(0);
+            values.Resize(0);
+            std::fill(rowStart.begin(), rowStart.end(), 0);
+        }
+    public:
+        static constexpr bool contiguous = false;
+        static constexpr bool sparse = true;
+
+        CsrTriangleStorage(int size, bool upper) : size(size), upper(upper), rowStart(size + 1) {}
+        explicit CsrTriangleStorage(const PackedTriangleStorage<T>& dense) : CsrTriangleStorage(dense.GetSize(), dense.GetIsUpper()) {
+            const T* cell = dense.Data();
+            for (int i = 0; i < size; ++i) {
+                for (int j = dense.RowBegin(i), end = j + dense.RowLength(i); j < end; ++j, ++cell) {
+                    if (*cell != T()) {
+                        columns.Emplace(j);
+                        values.Emplace(*cell);
+                    }
+                }
+                rowStart.begin()[i + 1] = values.GetSize();
+            }
+        }
+
+        int GetSize() const {
+            return size;
+        }
+        bool GetIsUpper() const {
+            return upper;
+        }
+        int NonZeroCount() const {
+            return values.GetSize();
+        }
+        bool InTriangle(int i, int j) const {
+            return upper ? i <= j : i >= j;
+        }
+
+        T Get(int i, int j) const {
+            int k = Find(i, j);
+            return k < 0 ? T() : values.begin()[k];
+        }
+        // Zeros are not kept: setting one removes the cell
+        void Set(const T& item, int i, int j) {
+            if (!InTriangle(i, j))
+                return;
+            int k = Find(i, j);
+            if (k >= 0 && item != T()) {
+                values.begin()[k] = item;
+                return;
+            }
+            if (k < 0 && item == T())
+                return;
+            if (k >= 0) {
+                std::move(columns.begin() + k + 1, columns.end(), columns.begin() + k);
+                std::move(values.begin() + k + 1, values.end(), values.begin() + k);
+                columns.Resize(columns.GetSize() - 1);
+                values.Resize(values.GetSize() - 1);
+            } else {
+                const int* first = columns.begin() + rowStart.begin()[i];
+                const int* last = columns.begin() + rowStart.begin()[i + 1];
+                k = static_cast<int>(std::lower_bound(first, last, j) - columns.begin());
+                columns.EmplaceAt(k, j);
+                values.EmplaceAt(k, item);
+            }
+            int shift = item == T() ? -1 : 1;
+            for (int row = i + 1; row <= size; ++row)
+                rowStart.begin()[row] += shift;
+        }
+
+        // f(i, j, item) for the nonzero cells only
+        template <typename F>
+        void ForEachNonZero(F f) const {
+            for (int i = 0; i < size; ++i)
+                for (int k = rowStart.begin()[i]; k < rowStart.begin()[i + 1]; ++k)
+                    f(i, columns.begin()[k], values.begin()[k]);
+        }
+        // Every cell of the triangle, zeros included, as the dense storages walk them
+        template <typename F>
+        void ForEachStored(F f) const {
+            ForEachCell([&](int i, int j, const T& item) {
+                if (InTriangle(i, j))
+                    f(item);
+            });
+        }
+        template <typename F>
+        void ForEachCell(F f) const {
+            const T zero = T();
+            for (int i = 0; i < size; ++i) {
+                int k = rowStart.begin()[i], end = rowStart.begin()[i + 1];
+                for (int j = 0; j < size; ++j)
+                    f(i, j, k < end && columns.begin()[k] == j ? values.begin()[k++] : zero);
+            }
+        }
+
+        void Fill(const T& item) {
+            if (item == T()) {
+                Clear();
+                return;
+            }
+            PackedTriangleStorage<T> dense(size, upper);
+            std::fill_n(dense.Data(), dense.StoredCount(), item);
+            *this = CsrTriangleStorage<T>(dense);
+        }
+        void Scale(const T& c) {
+            if (c == T()) {
+                Clear();
+                return;
+            }
+            for (T& item : values)
+                item = item * c;
+        }
+        // Merges the rows of both matrices, cells that cancel out are dropped
+        void Add(const CsrTriangleStorage<T>& other) {
+            CsrTriangleStorage<T> sum(size, upper);
+            sum.columns.Reserve(NonZeroCount() + other.NonZeroCount());
+            sum.values.Reserve(NonZeroCount() + other.NonZeroCount());
+            auto push = [&sum](int j, const T& item) {
+                if (item != T()) {
+                    sum.columns.Emplace(j);
+                    sum.values.Emplace(item);
+                }
+            };
+            for (int i = 0; i < size; ++i) {
+                int a = rowStart.begin()[i], aEnd = rowStart.begin()[i + 1];
+                int b = other.rowStart.begin()[i], bEnd = other.rowStart.begin()[i + 1];
+                while (a < aEnd || b < bEnd) {
+                    int ja = a < aEnd ? columns.begin()[a] : size;
+                    int jb = b < bEnd ? other.columns.begin()[b] : size;
+                    if (ja < jb)
+                        push(ja, values.begin()[a++]);
+                    else if (jb < ja)
+                        push(jb, other.values.begin()[b++]);
+                    else
+                        push(ja, values.begin()[a++] + other.values.begin()[b++]);
+                }
+                sum.rowStart.begin()[i + 1] = sum.values.GetSize();
+            }
+            *this = std::move(sum);
+        }
+        double SumSquares() const {
+            Lab::Kernels::KahanSum sum;
+            for (const T& item : values)
+                sum.Add(static_cast<double>(item) * static_cast<double>(item));
+            return sum.sum;
+        }
+
+        // y = A * x
+        void MultiplyVector(const T* x, T* y) const {
+            for (int i = 0; i < size; ++i) {
+                T sum = T();
+                for (int k = rowStart.begin()[i]; k < rowStart.begin()[i + 1]; ++k)
+                    sum = sum + values.begin()[k] * x[columns.begin()[k]];
+                y[i] = sum;
+            }
+        }
+        // A * B row by row (Gustavson): row i of the product gathers a[i][k] * (row k of b). A scratch row
+        // and the list of columns it touched keep each row at O(products) instead of O(n)
+        CsrTriangleStorage<T> Multiply(const CsrTriangleStorage<T>& b) const {
+            CsrTriangleStorage<T> product(size, upper);
+            DynamicArray<T> scratch(size);
+            DynamicArray<char> used(size);
+            DynamicArray<int> touched;
+            for (int i = 0; i < size; ++i) {
+                for (int ka = rowStart.begin()[i]; ka < rowStart.begin()[i + 1]; ++ka) {
+                    int k = columns.begin()[ka];
+                    T a = values.begin()[ka];
+                    for (int kb = b.rowStart.begin()[k]; kb < b.rowStart.begin()[k + 1]; ++kb) {
+                        int j = b.columns.begin()[kb];
+                        if (!used.begin()[j]) {
+                            used.begin()[j] = 1;
+                            touched.Emplace(j);
+                        }
+                        scratch.begin()[j] = scratch.begin()[j] + a * b.values.begin()[kb];
+                    }
+                }
+                std::sort(touched.begin(), touched.end());
+                for (int j : touched) {
+                    if (scratch.begin()[j] != T()) {
+                        product.columns.Emplace(j);
+                        product.values.Emplace(scratch.begin()[j]);
+                    }
+                    scratch.begin()[j] = T();
+                    used.begin()[j] = 0;
+                }
+                touched.Resize(0);
+                product.rowStart.begin()[i + 1] = product.values.GetSize();
+            }
+            return product;
+        }
+        // Back or forward substitution over the nonzeros, x holds b on entry
+        void Solve(T* x) const {
+            for (int step = 0; step < size; ++step) {
+                int i = upper ? size - 1 - step : step;
+                T diagonal = T();
+                T solved = T();
+                for (int k = rowStart.begin()[i]; k < rowStart.begin()[i + 1]; ++k) {
+                    if (columns.begin()[k] == i)
+                        diagonal = values.begin()[k];
+                    else
+                        solved = solved + values.begin()[k] * x[columns.begin()[k]];
+                }
+                if (diagonal == T())
+                    throw Lab::Singular("Triangle matrix is singular, zero on the diagonal in row " + std::to_string(i));
+                x[i] = (x[i] - solved) / diagonal;
+            }
+        }
+    };
+}
\ No newline at end of file
@@ -0,0 +1,198 @@
+#pragma once
+
+#include <cstdint>
+#include "intersection.hpp"
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define INTERSECTION_X86 1
+#else
+#define INTERSECTION_X86 0
+#endif
+
+namespace intersection {
+	// Segments in structure-of-arrays layout: one array per coordinate, so that one vector load
+	// takes the same coordinate of consecutive segments
+	struct segment_batch {
+		std::vector <double> x1, y1, x2, y2;
+
+		segment_batch () {}
+		explicit segment_batch (const std::vector <segment> &segments) {
+			x1.reserve(segments.size());
+			y1.reserve(segments.size());
+			x2.reserve(segments.size());
+			y2.reserve(segments.size());
+			for (auto &s : segments)
+				push_back(s);
+		}
+		void push_back (const segment &s) {
+			x1.push_back(s.begin().x());
+			y1.push_back(s.begin().y());
+			x2.push_back(s.end().x());
+			y2.push_back(s.end().y());
+		}
+		std::size_t size () const {return x1.size();}
+	};
+
+	// The instruction set is picked once at runtime, the scalar kernel runs everywhere
+	enum class simd_level { scalar, sse2, avx2 };
+
+	inline simd_level detect_simd_level () {
+#if INTERSECTION_X86
+		__builtin_cpu_init();
+		if (__builtin_cpu_supports("avx2"))
+			return simd_level::avx2;
+		if (__builtin_cpu_supports("sse2"))
+			return simd_level::sse2;
+#endif
+		return simd_level::scalar;
+	}
+
+	inline simd_level &active_simd_level () {
+		static simd_level level = detect_simd_level();
+		return level;
+	}
+
+	inline simd_level get_simd_level () {
+		return active_simd_level();
+	}
+
+	// Lets benchmarks pin a lower level, asking for more than the CPU has is clamped
+	inline void set_simd_level (simd_level level) {
+		active_simd_level() = std::min(level, detect_simd_level());
+	}
+
+	namespace batch {
+		// Same tolerance and the same arithmetic as intersect() with epsilon_predicate, so every
+		// kernel gives its answer bit for bit
+		const double EPS = 0.0001;
+
+		struct query {
+			double ax, ay, bx, by, min_x, max_x, min_y, max_y;
+			query (const pt &a, const pt &b): ax(a.x()), ay(a.y()), bx(b.x()), by(b.y()),
+				min_x(std::min(ax, bx)), max_x(std::max(ax, bx)), min_y(std::min(ay, by)), max_y(std::max(ay, by)) {}
+		};
+
+		// Bitwise operators instead of && and ||: random candidates make every branch unpredictable
+		inline bool test (const query &q, double cx, double cy, double dx, double dy) {
+			bool box = (std::max(q.min_x, std::min(cx, dx)) <= std::min(q.max_x, std::max(cx, dx)))
+				& (std::max(q.min_y, std::min(cy, dy)) <= std::min(q.max_y, std::max(cy, dy)));
+			double d1 = (q.bx - q.ax) * (cy - q.ay) - (q.by - q.ay) * (cx - q.ax);
+			double d2 = (q.bx - q.ax) * (dy - q.ay) - (q.by - q.ay) * (dx - q.ax);
+			double d3 = (dx - cx) * (q.ay - cy) - (dy - cy) * (q.ax - cx);
+			double d4 = (dx - cx) * (q.by - cy) - (dy - cy) * (q.bx - cx);
+			bool apart = ((d1 > EPS) & (d2 > EPS)) | ((d1 < -EPS) & (d2 < -EPS))
+				| ((d3 > EPS) & (d4 > EPS)) | ((d3 < -EPS) & (d4 < -EPS));
+			return box & !apart;
+		}
+
+		inline void scalar (const query &q, const segment_batch &c, std::size_t from, std::uint64_t *mask) {
+			for (std::size_t i = from; i < c.size(); ++i)
+				mask[i >> 6] |= std::uint64_t(test(q, c.x1[i], c.y1[i], c.x2[i], c.y2[i])) << (i & 63);
+		}
+
+#if INTERSECTION_X86
+		__attribute__((target("avx2"))) inline void avx2 (const query &q, const segment_batch &c, std::uint64_t *mask) {
+			const __m256d ax = _mm256_set1_pd(q.ax), ay = _mm256_set1_pd(q.ay);
+			const __m256d bx = _mm256_set1_pd(q.bx), by = _mm256_set1_pd(q.by);
+			const __m256d abx = _mm256_set1_pd(q.bx - q.ax), aby = _mm256_set1_pd(q.by - q.ay);
+			const __m256d min_x = _mm256_set1_pd(q.min_x), max_x = _mm256_set1_pd(q.max_x);
+			const __m256d min_y = _mm256_set1_pd(q.min_y), max_y = _mm256_set1_pd(q.max_y);
+			const __m256d eps = _mm256_set1_pd(EPS), neg_eps = _mm256_set1_pd(-EPS);
+			std::size_t i = 0;
+			for (; i + 4 <= c.size(); i += 4) {
+				__m256d cx = _mm256_loadu_pd(&c.x1[i]), cy = _mm256_loadu_pd(&c.y1[i]);
+				__m256d dx = _mm256_loadu_pd(&c.x2[i]), dy = _mm256_loadu_pd(&c.y2[i]);
+				__m256d box = _mm256_and_pd(
+					_mm256_cmp_pd(_mm256_max_pd(min_x, _mm256_min_pd(cx, dx)), _mm256_min_pd(max_x, _mm256_max_pd(cx, dx)), _CMP_LE_OQ),
+					_mm256_cmp_pd(_mm256_max_pd(min_y, _mm256_min_pd(cy, dy)), _mm256_min_pd(max_y, _mm256_max_pd(cy, dy)), _CMP_LE_OQ));
+				__m256d cdx = _mm256_sub_pd(dx, cx), cdy = _mm256_sub_pd(dy, cy);
+				__m256d d1 = _mm256_sub_pd(_mm256_mul_pd(abx, _mm256_sub_pd(cy, ay)), _mm256_mul_pd(aby, _mm256_sub_pd(cx, ax)));
+				__m256d d2 = _mm256_sub_pd(_mm256_mul_pd(abx, _mm256_sub_pd(dy, ay)), _mm256_mul_pd(aby, _mm256_sub_pd(dx, ax)));
+				__m256d d3 = _mm256_sub_pd(_mm256_mul_pd(cdx, _mm256_sub_pd(ay, cy)), _mm256_mul_pd(cdy, _mm256_sub_pd(ax, cx)));
+				__m256d d4 = _mm256_sub_pd(_mm256_mul_pd(cdx, _mm256_sub_pd(by, cy)), _mm256_mul_pd(cdy, _mm256_sub_pd(bx, cx)));
+				// Both ends strictly on one side of the other segment's line means no intersection
+				__m256d apart = _mm256_or_pd(
+					_mm256_or_pd(
+						_mm256_and_pd(_mm256_cmp_pd(d1, eps, _CMP_GT_OQ), _mm256_cmp_pd(d2, eps, _CMP_GT_OQ)),
+						_mm256_and_pd(_mm256_cmp_pd(d1, neg_eps, _CMP_LT_OQ), _mm256_cmp_pd(d2, neg_eps, _CMP_LT_OQ))),
+					_mm256_or_pd(
+						_mm256_and_pd(_mm256_cmp_pd(d3, eps, _CMP_GT_OQ), _mm256_cmp_pd(d4, eps, _CMP_GT_OQ)),
+						_mm256_and_pd(_mm256_cmp_pd(d3, neg_eps, _CMP_LT_OQ), _mm256_cmp_pd(d4, neg_eps, _CMP_LT_OQ))));
+				std::uint64_t bits = _mm256_movemask_pd(_mm256_andnot_pd(apart, box));
+				mask[i >> 6] |= bits << (i & 63);
+			}
+			scalar(q, c, i, mask);
+		}
+
+		__attribute__((target("sse2"))) inline void sse2 (const query &q, const segment_batch &c, std::uint64_t *mask) {
+			const __m128d ax = _mm_set1_pd(q.ax), ay = _mm_set1_pd(q.ay);
+			const __m128d bx = _mm_set1_pd(q.bx), by = _mm_set1_pd(q.by);
+			const __m128d abx = _mm_set1_pd(q.bx - q.ax), aby = _mm_set1_pd(q.by - q.ay);
+			const __m128d min_x = _mm_set1_pd(q.min_x), max_x = _mm_set1_pd(q.max_x);
+			const __m128d min_y = _mm_set1_pd(q.min_y), max_y = _mm_set1_pd(q.max_y);
+			const __m128d eps = _mm_set1_pd(EPS), neg_eps = _mm_set1_pd(-EPS);
+			std::size_t i = 0;
+			for (; i + 2 <= c.size(); i += 2) {
+				__m128d cx = _mm_loadu_pd(&c.x1[i]), cy = _mm_loadu_pd(&c.y1[i]);
+				__m128d dx = _mm_loadu_pd(&c.x2[i]), dy = _mm_loadu_pd(&c.y2[i]);
+				__m128d box = _mm_and_pd(
+					_mm_cmple_pd(_mm_max_pd(min_x, _mm_min_pd(cx, dx)), _mm_min_pd(max_x, _mm_max_pd(cx, dx))),
+					_mm_cmple_pd(_mm_max_pd(min_y, _mm_min_pd(cy, dy)), _mm_min_pd(max_y, _mm_max_pd(cy, dy))));
+				__m128d cdx = _mm_sub_pd(dx, cx), cdy = _mm_sub_pd(dy, cy);
+				__m128d d1 = _mm_sub_pd(_mm_mul_pd(abx, _mm_sub_pd(cy, ay)), _mm_mul_pd(aby, _mm_sub_pd(cx, ax)));
+				__m128d d2 = _mm_sub_pd(_mm_mul_pd(abx, _mm_sub_pd(dy, ay)), _mm_mul_pd(aby, _mm_sub_pd(dx, ax)));
+				__m128d d3 = _mm_sub_pd(_mm_mul_pd(cdx, _mm_sub_pd(ay, cy)), _mm_mul_pd(cdy, _mm_sub_pd(ax, cx)));
+				__m128d d4 = _mm_sub_pd(_mm_mul_pd(cdx, _mm_sub_pd(by, cy)), _mm_mul_pd(cdy, _mm_sub_pd(bx, cx)));
+				__m128d apart = _mm_or_pd(
+					_mm_or_pd(
+						_mm_and_pd(_mm_cmpgt_pd(d1, eps), _mm_cmpgt_pd(d2, eps)),
+						_mm_and_pd(_mm_cmplt_pd(d1, neg_eps), _mm_cmplt_pd(d2, neg_eps))),
+					_mm_or_pd(
+						_mm_and_pd(_mm_cmpgt_pd(d3, eps), _mm_cmpgt_pd(d4, eps)),
+						_mm_and_pd(_mm_cmplt_pd(d3, neg_eps), _mm_cmplt_pd(d4, neg_eps))));
+				std::uint64_t bits = _mm_movemask_pd(_mm_andnot_pd(apart, box));
+				mask[i >> 6] |= bits << (i & 63);
+			}
+			scalar(q, c, i, mask);
+		}
+#endif
+	}
+
+	// Tests segment a-b against every candidate and sets bit i of mask, which holds
+	// (candidates.size() + 63) / 64 words, when candidate i intersects it. The answers are
+	// those of intersect<epsilon_predicate>(a, b, c, d)
+	inline void intersect_batch (const pt &a, const pt &b, const segment_batch &candidates, std::uint64_t *mask) {
+		std::fill(mask, mask + (candidates.size() + 63) / 64, 0);
+		batch::query q(a, b);
+#if INTERSECTION_X86
+		switch (get_simd_level()) {
+		case simd_level::avx2:
+			batch::avx2(q, candidates, mask);
+			return;
+		case simd_level::sse2:
+			batch::sse2(q, candidates, mask);
+			return;
+		default:
+			break;
+		}
+#endif
+		batch::scalar(q, candidates, 0, mask);
+	}
+
+	inline std::vector <std::uint64_t> intersect_batch (const pt &a, const pt &b, const segment_batch &candidates) {
+		std::vector <std::uint64_t> mask((candidates.size() + 63) / 64);
+		intersect_batch(a, b, candidates, mask.data());
+		return mask;
+	}
+
+	// Indices of the candidates that intersect segment a-b, in increasing order
+	inline std::vector <std::size_t> intersecting (const pt &a, const pt &b, const segment_batch &candidates) {
+		std::vector <std::uint64_t> mask = intersect_batch(a, b, candidates);
+		std::vector <std::size_t> found;
+		for (std::size_t word = 0; word < mask.size(); ++word)
+			for (std::uint64_t bits = mask[word]; bits; bits &= bits - 1)
+				found.push_back(word * 64 + __builtin_ctzll(bits));
+		return found;
+	}
+}
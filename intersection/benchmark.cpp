@@ -0,0 +1,145 @@
+#include <chrono>
+#include <iomanip>
+#include "batch_intersect.hpp"
+#include "spatial_index.hpp"
+
+// Throughput of one query segment against many candidates: the pairwise intersect() on pt
+// objects against the batch kernels on structure-of-arrays data, in pairs per second
+namespace {
+	const int CANDIDATES = 4096;
+	const int QUERIES = 2000;
+
+	template <typename F>
+	double seconds (F f) {
+		auto start = std::chrono::high_resolution_clock::now();
+		f();
+		auto stop = std::chrono::high_resolution_clock::now();
+		return std::chrono::duration<double>(stop - start).count();
+	}
+
+	void report (const std::string &name, double s, long long hits) {
+		double pairs = double(CANDIDATES) * QUERIES;
+		std::cout << std::setiosflags(std::ios::left) << std::setw(24) << name
+				  << std::setw(12) << (std::to_string(int(s * 1e3)) + " ms")
+				  << std::setw(20) << ((long long)(pairs / s)) << "pairs/s  (" << hits << " hits)" << std::endl;
+	}
+
+	// Short segments, uniform over the square or with 9 in 10 packed into a corner one hundredth wide
+	std::vector <intersection::segment> short_segments (int n, bool skewed) {
+		std::vector <intersection::segment> segments;
+		for (int i = 0; i < n; ++i) {
+			double scale = skewed && i % 10 ? 0.01 : 1;
+			double x = intersection::rand_val() * scale, y = intersection::rand_val() * scale;
+			segments.push_back(intersection::segment(intersection::pt(x, y),
+				intersection::pt(x + intersection::rand_val() * 0.02 * scale, y + intersection::rand_val() * 0.02 * scale)));
+		}
+		return segments;
+	}
+
+	void report_query (const std::string &name, double s, int queries, long long hits) {
+		std::cout << std::setiosflags(std::ios::left) << std::setw(24) << name
+				  << std::setw(12) << (std::to_string(int(s * 1e6 / queries)) + " us")
+				  << "per query  (" << hits << " hits)" << std::endl;
+	}
+
+	template <typename Index>
+	void bench_index (const std::string &name, const std::vector <intersection::segment> &stored, const std::vector <intersection::segment> &queries) {
+		Index index(stored);
+		long long hits = 0;
+		double s = seconds([&] {
+			for (auto &q : queries)
+				hits += index.intersecting(q).size();
+		});
+		report_query(name, s, queries.size(), hits);
+	}
+
+	template <typename Predicate>
+	void bench_predicate (const std::string &name, const std::vector <intersection::pt> &points) {
+		const int ROUNDS = 20;
+		long long left = 0;
+		double s = seconds([&] {
+			for (int k = 0; k < ROUNDS; ++k)
+				for (std::size_t i = 0; i + 2 < points.size(); ++i)
+					left += Predicate::orientation(points[i], points[i + 1], points[i + 2]) > 0;
+		});
+		std::cout << std::setiosflags(std::ios::left) << std::setw(24) << name
+				  << std::setw(12) << (std::to_string(int(s * 1e3)) + " ms")
+				  << std::setw(20) << ((long long)(ROUNDS * (points.size() - 2) / s)) << "tests/s  (" << left << " left turns)" << std::endl;
+	}
+
+	// Points on a whole number grid, every third one on the line through the two before it
+	void bench_predicates () {
+		std::vector <intersection::pt> points;
+		for (int i = 0; i < 300000; ++i) {
+			if (i % 3 == 2) {
+				const intersection::pt &a = points[i - 2], &b = points[i - 1];
+				points.push_back(intersection::pt(2 * b.x() - a.x(), 2 * b.y() - a.y()));
+			} else
+				points.push_back(intersection::pt(std::rand() % 2000000 - 1000000, std::rand() % 2000000 - 1000000));
+		}
+		bench_predicate<intersection::epsilon_predicate>("epsilon_predicate", points);
+		bench_predicate<intersection::exact_predicate>("exact_predicate", points);
+		bench_predicate<intersection::integer_predicate>("integer_predicate", points);
+	}
+
+	void bench_indexes (bool skewed) {
+		std::cout << (skewed ? "SKEWED" : "UNIFORM") << " 100000 segments, 1000 queries:" << std::endl;
+		std::vector <intersection::segment> stored = short_segments(100000, skewed);
+		std::vector <intersection::segment> queries = short_segments(1000, skewed);
+		long long hits = 0;
+		double s = seconds([&] {
+			for (auto &q : queries)
+				for (auto &c : stored)
+					hits += intersection::intersect<intersection::epsilon_predicate>(q.begin(), q.end(), c.begin(), c.end());
+		});
+		report_query("brute force", s, queries.size(), hits);
+		bench_index<intersection::uniform_grid>("uniform_grid", stored, queries);
+		bench_index<intersection::rtree>("rtree", stored, queries);
+	}
+}
+
+int main () {
+	srand(42);
+	std::vector <intersection::segment> candidates;
+	for (int i = 0; i < CANDIDATES; ++i)
+		candidates.push_back(intersection::segment(
+			intersection::pt(intersection::rand_val(), intersection::rand_val()),
+			intersection::pt(intersection::rand_val(), intersection::rand_val())));
+	std::vector <intersection::segment> queries;
+	for (int i = 0; i < QUERIES; ++i)
+		queries.push_back(intersection::segment(
+			intersection::pt(intersection::rand_val(), intersection::rand_val()),
+			intersection::pt(intersection::rand_val(), intersection::rand_val())));
+	intersection::segment_batch batch(candidates);
+
+	long long hits = 0;
+	double s = seconds([&] {
+		for (auto &q : queries)
+			for (auto &c : candidates)
+				hits += intersection::intersect(q.begin(), q.end(), c.begin(), c.end());
+	});
+	report("intersect()", s, hits);
+
+	const char *names[] = {"batch scalar", "batch SSE2", "batch AVX2"};
+	intersection::simd_level levels[] = {intersection::simd_level::scalar, intersection::simd_level::sse2, intersection::simd_level::avx2};
+	std::vector <std::uint64_t> mask((CANDIDATES + 63) / 64);
+	for (int k = 0; k < 3; ++k) {
+		if (levels[k] > intersection::detect_simd_level())
+			continue;
+		intersection::set_simd_level(levels[k]);
+		hits = 0;
+		s = seconds([&] {
+			for (auto &q : queries) {
+				intersection::intersect_batch(q.begin(), q.end(), batch, mask.data());
+				for (auto word : mask)
+					hits += __builtin_popcountll(word);
+			}
+		});
+		report(names[k], s, hits);
+	}
+
+	bench_predicates();
+	bench_indexes(false);
+	bench_indexes(true);
+	return 0;
+}
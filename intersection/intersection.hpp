@@ -0,0 +1,447 @@
+#pragma once
+
+#include <inttypes.h>
+#include <cstdio>
+#include <cmath>
+#include <random>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <vector>
+#include <string>
+#include <stdexcept>
+#include <algorithm>
+
+typedef int8_t color_t;
+
+namespace intersection {
+	// Opens and closes lines.txt on every call, segment_writer is the one for many lines
+	inline void writeln (const std::string &s, bool append = true) {
+		std::ofstream lines;
+		if (append)
+			lines.open ("lines.txt", std::ios::out | std::ios::app);
+		else
+			lines.open ("lines.txt");
+		if (lines.is_open()) {
+			lines << s << std::endl;
+			lines.close();
+		} else 
+			throw std::runtime_error("Unable to open file lines.txt");
+	}
+
+	class pt {
+		double x_c, y_c;
+	public:
+		pt (const double &a, const double &b): x_c(a), y_c(b) {}
+		double x () const {return x_c;}
+		double y () const {return y_c;}
+		friend std::ostream& operator << (std::ostream& o, const pt &x);
+	};
+
+	class sign {
+		int8_t sgn;
+		const double EPS_POS = 0.0001;
+		const double EPS_NEG = -0.0001;
+	public:
+		sign (const double &val) {
+			if (val <= EPS_POS && val >= EPS_NEG) {
+				sgn = 0;
+			} else if (val > EPS_POS) {
+				sgn = 1;
+			} else {
+				sgn = -1;
+			}
+		}
+		explicit sign (const char &sign) {
+			switch (sign) {
+			case '+': 
+				sgn = 1;
+				break;
+			case '-':
+				sgn = -1;
+				break;
+			default:
+				sgn = 0;
+			}
+		}
+		static sign of (int s) {
+			return sign(s > 0 ? '+' : (s < 0 ? '-' : '0'));
+		}
+		int8_t sn() const {
+			return sgn;
+		}
+		sign operator*(const sign &rhs) const {
+			switch (sgn * rhs.sgn) {
+			case 0:
+				return sign('0');
+			case 1:
+				return sign('+');
+			default:
+				return sign('-');
+			}
+		}
+	};
+	
+	// Orientation predicates: orientation(a, b, c) is 1 for a left turn a -> b -> c, -1 for a right
+	// turn and 0 for collinear points. They are policies picked at compile time, a template argument
+	// of area_sign and intersect, or for the whole program with -DINTERSECTION_PREDICATE=...
+
+	// Rounded area with the absolute tolerance of sign: cheap, but whether points count as collinear
+	// depends on the scale of the coordinates
+	struct epsilon_predicate {
+		static int orientation (const pt &a, const pt &b, const pt &c) {
+			return sign((b.x() - a.x()) * (c.y() - a.y()) - (b.y() - a.y()) * (c.x() - a.x())).sn();
+		}
+	};
+
+	// Exact sign of the area for any double coordinates, after Shewchuk's orient2d. The rounded area
+	// is trusted when it is larger than its error bound, which is nearly always. Otherwise the six
+	// products are taken exactly with fma and summed into an expansion without rounding. Needs IEEE
+	// doubles with round to nearest, so no -ffast-math and no x87
+	struct exact_predicate {
+		static int orientation (const pt &a, const pt &b, const pt &c) {
+			const double ERR_BOUND = (3.0 + 16.0 * EPSILON) * EPSILON;
+			double left = (a.x() - c.x()) * (b.y() - c.y());
+			double right = (a.y() - c.y()) * (b.x() - c.x());
+			double det = left - right;
+			double bound = ERR_BOUND * (std::fabs(left) + std::fabs(right));
+			if (det > bound || -det > bound)
+				return (det > 0) - (det < 0);
+			return exact_orientation(a, b, c);
+		}
+	private:
+		static constexpr double EPSILON = 1.1102230246251565e-16;	// 2^-53, half an ulp of 1
+
+		// Adds x to the expansion e[0..n): nonoverlapping components, smallest first, whose sum
+		// is exact (Shewchuk's Grow-Expansion)
+		static int grow (double *e, int n, double x) {
+			for (int i = 0; i < n; ++i) {
+				double sum = x + e[i];
+				double virt = sum - x;
+				e[i] = (x - (sum - virt)) + (e[i] - virt);
+				x = sum;
+			}
+			e[n] = x;
+			return n + 1;
+		}
+
+		// Rounding error of diff = x - y (Shewchuk's Two-Diff)
+		static double diff_tail (double x, double y, double diff) {
+			double virt = x - diff;
+			return (x - (diff + virt)) + (virt - y);
+		}
+
+		// Sign of the exact sum of the products p[i][0] * p[i][1]
+		template <int N>
+		static int sum_sign (const double (&products)[N][2]) {
+			double e[2 * N];
+			int n = 0;
+			for (auto &p : products) {
+				double product = p[0] * p[1];
+				n = grow(e, n, product);
+				n = grow(e, n, std::fma(p[0], p[1], -product));
+			}
+			// The largest nonzero component outweighs all the others together
+			while (n > 0 && e[n - 1] == 0)
+				--n;
+			return n == 0 ? 0 : (e[n - 1] > 0) - (e[n - 1] < 0);
+		}
+
+		// When the four differences were exact, which is the usual case for nearly collinear points,
+		// two exact products settle it. Otherwise all six products of the expanded area are summed
+		static int exact_orientation (const pt &a, const pt &b, const pt &c) {
+			double acx = a.x() - c.x(), acy = a.y() - c.y(), bcx = b.x() - c.x(), bcy = b.y() - c.y();
+			if (diff_tail(a.x(), c.x(), acx) == 0 && diff_tail(a.y(), c.y(), acy) == 0
+				&& diff_tail(b.x(), c.x(), bcx) == 0 && diff_tail(b.y(), c.y(), bcy) == 0) {
+				const double products[2][2] = {{acx, bcy}, {-acy, bcx}};
+				return sum_sign(products);
+			}
+			const double products[6][2] = {
+				{b.x(), c.y()}, {-b.x(), a.y()}, {-a.x(), c.y()},
+				{-b.y(), c.x()}, {a.x(), b.y()}, {a.y(), c.x()}};
+			return sum_sign(products);
+		}
+	};
+
+#ifdef __SIZEOF_INT128__
+	// Exact for coordinates that are whole numbers below 2^61 in magnitude: the area is computed in
+	// __int128 without any branch
+	struct integer_predicate {
+		static int orientation (const pt &a, const pt &b, const pt &c) {
+			__int128_t area = __int128_t((long long)b.x() - (long long)a.x()) * ((long long)c.y() - (long long)a.y())
+				- __int128_t((long long)b.y() - (long long)a.y()) * ((long long)c.x() - (long long)a.x());
+			return (area > 0) - (area < 0);
+		}
+	};
+#endif
+
+#ifndef INTERSECTION_PREDICATE
+#define INTERSECTION_PREDICATE epsilon_predicate
+#endif
+	typedef INTERSECTION_PREDICATE default_predicate;
+
+	template <typename Predicate = default_predicate>
+	inline sign area_sign (const pt &a, const pt &b, const pt &c) {
+		return sign::of(Predicate::orientation(a, b, c));
+	}
+	
+	inline bool intersect_1 (double a, double b, double c, double d) {
+		if (a > b)  std::swap (a, b);
+		if (c > d)  std::swap (c, d);
+		return std::max(a,c) <= std::min(b,d);
+	}
+	
+	template <typename Predicate = default_predicate>
+	inline bool intersect (pt a, pt b, pt c, pt d) {
+		return intersect_1 (a.x(), b.x(), c.x(), d.x())
+			&& intersect_1 (a.y(), b.y(), c.y(), d.y())
+			&& ((area_sign<Predicate>(a, b, c) * area_sign<Predicate>(a, b, d)).sn() <= 0)
+			&& ((area_sign<Predicate>(c, d, a) * area_sign<Predicate>(c, d, b)).sn() <= 0);
+	}
+
+	inline double rand_val() {
+		return double(std::rand() - RAND_MAX / 2) / RAND_MAX;
+	}
+
+	class segment {
+		pt st, fn;
+		color_t color;
+	public:
+		segment (const double &ba, 
+				const double &bb, 
+				const double &ea, 
+				const double &eb, 
+				color_t c): st(ba, bb), fn(ea, eb), color(c) {}
+		segment (const pt &b,
+				const pt &e,
+				color_t c = 1): st(b), fn(e), color(c) {}
+		pt begin () const {return st;}
+		pt end () const {return fn;}
+		color_t get_color () const {return color;}
+		friend std::ostream& operator << (std::ostream& o, const segment &x);
+	};
+
+	class random_sequence {
+		std::vector <segment> segments;
+	public:
+		random_sequence (color_t color, int n = 5) {
+			pt prev (rand_val(), rand_val());
+			for (int i = 0; i < n; ++i) {
+				pt cur (rand_val(), rand_val());
+				segments.push_back(segment(prev.x(), prev.y(), cur.x(), cur.y(), color));
+				prev = cur;
+			}
+		}
+		const std::vector <segment> &get_segments () const {return segments;}
+		friend std::ostream& operator << (std::ostream& o, const random_sequence &x);
+	};
+
+	// Writes segments in the gnuplot format of plot.cmd: a "##x1 y1 x2 y2 colorNumber" header, then
+	// one "x1 y1 x2 y2 color" line per segment. The file stays open and lines gather in a buffer
+	// that goes out when full, on flush and on destruction. A disabled writer drops everything
+	class segment_writer {
+		std::ofstream file;
+		std::string buffer;
+		bool enabled;
+		static const std::size_t BUFFER_SIZE = 1 << 16;
+	public:
+		explicit segment_writer (const std::string &path = "lines.txt", bool enable = true): enabled(enable) {
+			if (!enabled)
+				return;
+			file.open(path);
+			if (!file.is_open())
+				throw std::runtime_error("Unable to open file " + path);
+			buffer.reserve(BUFFER_SIZE);
+			buffer += "##x1 y1 x2 y2 colorNumber\n";
+		}
+		~segment_writer () {
+			if (enabled && !buffer.empty())
+				file.write(buffer.data(), buffer.size());
+		}
+		bool is_enabled () const {return enabled;}
+
+		void write (const segment &s) {
+			if (!enabled)
+				return;
+			char line[128];
+			int length = std::snprintf(line, sizeof line, "%f %f %f %f %d\n",
+				s.begin().x(), s.begin().y(), s.end().x(), s.end().y(), int(s.get_color()));
+			if (length < 0 || length >= int(sizeof line))
+				throw std::runtime_error("Segment does not fit in a line");
+			if (buffer.size() + length > BUFFER_SIZE)
+				flush_buffer();
+			buffer.append(line, length);
+		}
+		void write (const random_sequence &sequence) {
+			for (auto &s : sequence.get_segments())
+				write(s);
+		}
+		void flush () {
+			if (!enabled)
+				return;
+			flush_buffer();
+			file.flush();
+			if (!file)
+				throw std::runtime_error("Unable to write segments");
+		}
+	private:
+		void flush_buffer () {
+			file.write(buffer.data(), buffer.size());
+			buffer.clear();
+		}
+	};
+/*
+	class random_pt {
+		std::vector <pt> points;
+	public:
+		random_pt (int n = 5) {
+			for (int i = 0; i < n; ++i) {
+				points.push_back(pt(rand_val(), rand_val()));
+			}
+		}
+
+		pt find_leftmost_point() const {
+			pt leftmost_point(0.0, 0.0);
+			double leftmost_x, leftmost_y;
+			bool uninit = true;
+			for (auto &point : points) {
+				double x = point.x();
+				if (uninit || x < leftmost_x) {
+					leftmost_x = x;
+					leftmost_y = point.y();
+					leftmost_point = point;
+					uninit = false;
+				} else if (x < leftmost_x + 0.0001 && x > leftmost_x - 0.0001) {
+					if (point.y() > leftmost_y) {
+						leftmost_y = point.y();
+						leftmost_point = point;
+					}
+				}
+			}
+			return leftmost_point;
+		}
+
+		pt find_rightmost_point() const {
+			pt rightmost_point(0.0, 0.0);
+			double rightmost_x, rightmost_y;
+			bool uninit = true;
+			for (auto &point : points) {
+				double x = point.x();
+				if (uninit || x > rightmost_x) {
+					rightmost_x = x;
+					rightmost_y = point.y();
+					rightmost_point = point;
+					uninit = false;
+				} else if (x < rightmost_x + 0.0001 && x > rightmost_x - 0.0001) {
+					if (point.y() > rightmost_y) {
+						rightmost_y = point.y();
+						rightmost_point = point;
+					}
+				}
+			}
+			return rightmost_point;
+		}
+
+		int8_t is_point_above_the_line (const pt &point, const segment &line_points) const {
+			double px = point.x(), py = point.y();
+			pt P1 = line_points.begin();
+			pt P2 = line_points.end();
+			double P1x = P1.x(), P1y = P1.y();
+			double P2x = P2.x(), P2y = P2.y();
+			double det = (P1x - px) * (P2y - py) - (P1y - py) * (P2x - px);
+			sign s(det);
+			return s.sn();
+		}
+
+		std::vector <std::vector <pt>> sort_array_into_A_B_C(const segment &line_points) {
+			pt P1 = line_points.begin();
+			pt P2 = line_points.end();
+			double x_lm = P1.x(), y_lm = P1.y();
+			double x_rm = P2.x(), y_rm = P2.y();
+			std::vector <pt> A_array, B_array, C_array;
+			for (auto &point : points) {
+				int8_t sign = is_point_above_the_line(point, line_points);
+				if (sign == 0)
+					C_array.push_back(point);
+				else if (sign == -1)
+					A_array.push_back(point);
+				else
+					B_array.push_back(point);
+			}
+			std::vector <std::vector <pt>> a;
+			a.push_back(A_array);
+			a.push_back(B_array);
+			a.push_back(C_array);
+        	return a;
+		}
+
+		void sort_and_merge_A_B_C_arrays(const std::vector <pt> &A_array, const std::vector <pt> &B_array, const std::vector <pt> &C_array) {
+			std::vector <pt> A_C_array;
+			for (auto &point : A_array) {
+				A_C_array.push_back(point);
+			}
+			for (auto &point : C_array) {
+				A_C_array.push_back(point);
+			}
+			std::sort(A_C_array.begin(), A_C_array.end(), [](pt a, pt b) { return a.x() < b.x(); });
+			std::sort(A_C_array.begin(), A_C_array.end(), [](pt a, pt b) { return a.x() > b.x(); });
+			std::vector <pt> merged_arrays;
+			for (auto &point : A_C_array) {
+				merged_arrays.push_back(point);
+			}
+			for (auto &point : B_array) {
+				merged_arrays.push_back(point);
+			}
+			points = merged_arrays;
+		}
+
+		void make_poligon_like() {
+			segment line_points (find_leftmost_point(), find_rightmost_point());
+			auto x = sort_array_into_A_B_C(line_points);
+			sort_and_merge_A_B_C_arrays(x[0], x[1], x[2]);
+		}
+
+		std::vector <pt> &return_val () {
+			return points;
+		}
+	};
+
+	class random_sequence_no_self_intersection {
+		std::vector <segment> segments;
+	public:
+		random_sequence_no_self_intersection (color_t color, int n = 5) {
+			random_pt poli (n);
+			poli.make_poligon_like();
+			bool started = true;
+			pt prev(0.0, 0.0);
+			for (auto &point : poli.return_val()) {
+				if (started) {
+					started = false;
+					prev = point;
+				} else {
+					segments.push_back(segment(prev.x(), prev.y(), point.x(), point.y(), color));
+					prev = point;
+				}
+			} 
+		}
+	};
+*/
+
+
+	inline std::ostream& operator << (std::ostream& o, const segment &x) {
+		o << "Segment is:\na: " << x.st << "\nb: " << x.fn << std::endl;
+		return o;
+	}
+
+	inline std::ostream& operator << (std::ostream& o, const pt &x) {
+		o << "(" << x.x_c << ", " << x.y_c << ")";
+		return o;
+	}
+
+	inline std::ostream& operator << (std::ostream& o, const random_sequence &x) {
+		for (auto &segm : x.segments) {
+			std::cout << segm;
+		}
+		return o;
+	}
+}
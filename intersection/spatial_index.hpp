@@ -0,0 +1,405 @@
+#pragma once
+
+#include <cmath>
+#include <limits>
+#include "intersection.hpp"
+
+namespace intersection {
+	// Axis-aligned bounding box, closed on all sides like the box test of intersect()
+	struct box {
+		double min_x, min_y, max_x, max_y;
+
+		box (): min_x(std::numeric_limits<double>::infinity()), min_y(std::numeric_limits<double>::infinity()),
+			max_x(-std::numeric_limits<double>::infinity()), max_y(-std::numeric_limits<double>::infinity()) {}
+		box (double x1, double y1, double x2, double y2): min_x(std::min(x1, x2)), min_y(std::min(y1, y2)),
+			max_x(std::max(x1, x2)), max_y(std::max(y1, y2)) {}
+		explicit box (const segment &s): box(s.begin().x(), s.begin().y(), s.end().x(), s.end().y()) {}
+
+		bool empty () const {return min_x > max_x;}
+		bool overlaps (const box &b) const {
+			return std::max(min_x, b.min_x) <= std::min(max_x, b.max_x)
+				&& std::max(min_y, b.min_y) <= std::min(max_y, b.max_y);
+		}
+		void extend (const box &b) {
+			min_x = std::min(min_x, b.min_x);
+			min_y = std::min(min_y, b.min_y);
+			max_x = std::max(max_x, b.max_x);
+			max_y = std::max(max_y, b.max_y);
+		}
+		double area () const {return empty() ? 0 : (max_x - min_x) * (max_y - min_y);}
+		double center_x () const {return (min_x + max_x) / 2;}
+		double center_y () const {return (min_y + max_y) / 2;}
+	};
+
+	// Stored segments by id. Ids stay valid until the segment is erased, then they are reused
+	class segment_table {
+		std::vector <segment> segments;
+		std::vector <box> boxes;
+		std::vector <bool> used;
+		std::vector <std::size_t> free_ids;
+	public:
+		std::size_t add (const segment &s) {
+			if (free_ids.empty()) {
+				segments.push_back(s);
+				boxes.push_back(box(s));
+				used.push_back(true);
+				return segments.size() - 1;
+			}
+			std::size_t id = free_ids.back();
+			free_ids.pop_back();
+			segments[id] = s;
+			boxes[id] = box(s);
+			used[id] = true;
+			return id;
+		}
+		bool remove (std::size_t id) {
+			if (!contains(id))
+				return false;
+			used[id] = false;
+			free_ids.push_back(id);
+			return true;
+		}
+		bool contains (std::size_t id) const {return id < used.size() && used[id];}
+		const segment &get (std::size_t id) const {return segments[id];}
+		const box &bounds (std::size_t id) const {return boxes[id];}
+		std::size_t size () const {return segments.size() - free_ids.size();}
+		std::size_t capacity () const {return segments.size();}
+
+		// Keeps the candidates that really intersect s, in increasing order of id
+		std::vector <std::size_t> filter (const segment &s, std::vector <std::size_t> candidates) const {
+			std::vector <std::size_t> found;
+			for (auto id : candidates)
+				if (intersect(s.begin(), s.end(), segments[id].begin(), segments[id].end()))
+					found.push_back(id);
+			std::sort(found.begin(), found.end());
+			return found;
+		}
+	};
+
+	// Fixed grid of cells over an area, every segment is listed in each cell its box covers. Best for
+	// short segments spread evenly, a segment across the whole area costs a visit to every cell.
+	// Segments outside the area go to the border cells, so nothing is lost, only slower
+	class uniform_grid {
+		segment_table table;
+		box area;
+		int cols, rows;
+		double cell_w, cell_h;
+		std::vector <std::vector <std::size_t>> cells;
+
+		int col (double x) const {
+			double c = std::floor((x - area.min_x) / cell_w);
+			return c < 0 ? 0 : (c >= cols ? cols - 1 : int(c));
+		}
+		int row (double y) const {
+			double r = std::floor((y - area.min_y) / cell_h);
+			return r < 0 ? 0 : (r >= rows ? rows - 1 : int(r));
+		}
+		std::vector <std::size_t> &cell (int c, int r) {return cells[std::size_t(r) * cols + c];}
+
+		void init (const box &bounds, int c, int r) {
+			if (c < 1 || r < 1)
+				throw std::invalid_argument("uniform_grid needs at least one cell per side");
+			area = bounds.empty() ? box(0, 0, 0, 0) : bounds;
+			cols = c;
+			rows = r;
+			cell_w = area.max_x > area.min_x ? (area.max_x - area.min_x) / cols : 1;
+			cell_h = area.max_y > area.min_y ? (area.max_y - area.min_y) / rows : 1;
+			cells.assign(std::size_t(cols) * rows, std::vector <std::size_t>());
+		}
+	public:
+		uniform_grid (const box &bounds, int c, int r) {
+			init(bounds, c, r);
+		}
+		// Covers the given segments with about one cell per segment
+		explicit uniform_grid (const std::vector <segment> &segments) {
+			box bounds;
+			for (auto &s : segments)
+				bounds.extend(box(s));
+			int side = std::max(1, int(std::ceil(std::sqrt(double(segments.size())))));
+			init(bounds, side, side);
+			for (auto &s : segments)
+				insert(s);
+		}
+
+		std::size_t insert (const segment &s) {
+			std::size_t id = table.add(s);
+			const box &b = table.bounds(id);
+			for (int r = row(b.min_y); r <= row(b.max_y); ++r)
+				for (int c = col(b.min_x); c <= col(b.max_x); ++c)
+					cell(c, r).push_back(id);
+			return id;
+		}
+		bool erase (std::size_t id) {
+			if (!table.contains(id))
+				return false;
+			const box &b = table.bounds(id);
+			for (int r = row(b.min_y); r <= row(b.max_y); ++r)
+				for (int c = col(b.min_x); c <= col(b.max_x); ++c) {
+					std::vector <std::size_t> &ids = cell(c, r);
+					auto it = std::find(ids.begin(), ids.end(), id);
+					*it = ids.back();
+					ids.pop_back();
+				}
+			table.remove(id);
+			return true;
+		}
+		bool contains (std::size_t id) const {return table.contains(id);}
+		const segment &get (std::size_t id) const {return table.get(id);}
+		std::size_t size () const {return table.size();}
+
+		// Ids of the stored segments whose boxes overlap the window. A segment that spans several
+		// cells is reported only from the first cell it shares with the window, so no id repeats
+		std::vector <std::size_t> query (const box &window) const {
+			std::vector <std::size_t> found;
+			if (window.empty())
+				return found;
+			int c1 = col(window.min_x), c2 = col(window.max_x);
+			int r1 = row(window.min_y), r2 = row(window.max_y);
+			for (int r = r1; r <= r2; ++r)
+				for (int c = c1; c <= c2; ++c)
+					for (auto id : cells[std::size_t(r) * cols + c]) {
+						const box &b = table.bounds(id);
+						if (b.overlaps(window) && c == std::max(c1, col(b.min_x)) && r == std::max(r1, row(b.min_y)))
+							found.push_back(id);
+					}
+			return found;
+		}
+		// Ids of the stored segments that intersect s, in increasing order
+		std::vector <std::size_t> intersecting (const segment &s) const {
+			return table.filter(s, query(box(s)));
+		}
+	};
+
+	// R-tree over the boxes of the segments. The constructor from a vector packs it with
+	// Sort-Tile-Recursive, which gives nearly full nodes that hardly overlap even on skewed data.
+	// Inserts go down the least enlargement path and split full nodes along their longer side,
+	// erases reinsert the entries of nodes that drop under half full
+	class rtree {
+		static const std::size_t MAX_ENTRIES = 16;
+		static const std::size_t MIN_ENTRIES = 6;
+		static const std::size_t NONE = std::size_t(-1);
+
+		struct node {
+			box bounds;
+			bool leaf;
+			std::size_t parent;
+			std::vector <std::size_t> entries;	// segment ids in leaves, child nodes otherwise
+		};
+
+		segment_table table;
+		std::vector <node> nodes;
+		std::vector <std::size_t> free_nodes;
+		std::vector <std::size_t> leaf_of;
+		std::size_t root;
+
+		const box &entry_bounds (const node &n, std::size_t entry) const {
+			return n.leaf ? table.bounds(entry) : nodes[entry].bounds;
+		}
+
+		std::size_t new_node (bool leaf) {
+			node n;
+			n.leaf = leaf;
+			n.parent = NONE;
+			if (free_nodes.empty()) {
+				nodes.push_back(n);
+				return nodes.size() - 1;
+			}
+			std::size_t id = free_nodes.back();
+			free_nodes.pop_back();
+			nodes[id] = n;
+			return id;
+		}
+
+		// Points the entries of n back at it and recomputes its box
+		void adopt (std::size_t n) {
+			node &nd = nodes[n];
+			nd.bounds = box();
+			for (auto entry : nd.entries) {
+				if (nd.leaf)
+					leaf_of[entry] = n;
+				else
+					nodes[entry].parent = n;
+				nd.bounds.extend(entry_bounds(nd, entry));
+			}
+		}
+
+		// Sort-Tile-Recursive: sorts the entries by x, cuts them into vertical slices, sorts every
+		// slice by y and fills nodes from it in order. Returns the new nodes
+		std::vector <std::size_t> pack (std::vector <std::size_t> entries, bool leaf) {
+			auto bounds_of = [&](std::size_t entry) -> const box & {return leaf ? table.bounds(entry) : nodes[entry].bounds;};
+			std::size_t count = (entries.size() + MAX_ENTRIES - 1) / MAX_ENTRIES;
+			std::size_t slices = std::size_t(std::ceil(std::sqrt(double(count))));
+			std::size_t per_slice = slices * MAX_ENTRIES;
+			std::sort(entries.begin(), entries.end(), [&](std::size_t a, std::size_t b) {
+				return bounds_of(a).center_x() < bounds_of(b).center_x();
+			});
+			std::vector <std::size_t> packed;
+			for (std::size_t from = 0; from < entries.size(); from += per_slice) {
+				auto first = entries.begin() + from;
+				auto last = entries.begin() + std::min(entries.size(), from + per_slice);
+				std::sort(first, last, [&](std::size_t a, std::size_t b) {
+					return bounds_of(a).center_y() < bounds_of(b).center_y();
+				});
+				for (auto it = first; it < last; it += std::min<std::ptrdiff_t>(MAX_ENTRIES, last - it)) {
+					std::size_t n = new_node(leaf);
+					nodes[n].entries.assign(it, it + std::min<std::ptrdiff_t>(MAX_ENTRIES, last - it));
+					adopt(n);
+					packed.push_back(n);
+				}
+			}
+			return packed;
+		}
+
+		std::size_t choose_leaf (const box &b) const {
+			std::size_t n = root;
+			while (!nodes[n].leaf) {
+				std::size_t best = NONE;
+				double best_growth = 0, best_area = 0;
+				for (auto child : nodes[n].entries) {
+					box grown = nodes[child].bounds;
+					grown.extend(b);
+					double area = nodes[child].bounds.area();
+					double growth = grown.area() - area;
+					if (best == NONE || growth < best_growth || (growth == best_growth && area < best_area)) {
+						best = child;
+						best_growth = growth;
+						best_area = area;
+					}
+				}
+				n = best;
+			}
+			return n;
+		}
+
+		// Moves the upper half of the entries of n, ordered along its longer side, to a new sibling
+		void split (std::size_t n) {
+			node &nd = nodes[n];
+			bool by_x = nd.bounds.max_x - nd.bounds.min_x >= nd.bounds.max_y - nd.bounds.min_y;
+			std::sort(nd.entries.begin(), nd.entries.end(), [&](std::size_t a, std::size_t b) {
+				const box &ba = entry_bounds(nd, a), &bb = entry_bounds(nd, b);
+				return by_x ? ba.center_x() < bb.center_x() : ba.center_y() < bb.center_y();
+			});
+			std::size_t sibling = new_node(nodes[n].leaf);
+			std::vector <std::size_t> &entries = nodes[n].entries;
+			std::size_t half = entries.size() / 2;
+			nodes[sibling].entries.assign(entries.begin() + half, entries.end());
+			entries.resize(half);
+			adopt(n);
+			adopt(sibling);
+			std::size_t parent = nodes[n].parent;
+			if (parent == NONE) {
+				root = new_node(false);
+				nodes[root].entries.push_back(n);
+				nodes[root].entries.push_back(sibling);
+				adopt(root);
+				return;
+			}
+			nodes[parent].entries.push_back(sibling);
+			nodes[sibling].parent = parent;
+		}
+
+		void insert_entry (std::size_t id) {
+			const box &b = table.bounds(id);
+			std::size_t n = choose_leaf(b);
+			nodes[n].entries.push_back(id);
+			leaf_of[id] = n;
+			for (; n != NONE; n = nodes[n].parent) {
+				nodes[n].bounds.extend(b);
+				if (nodes[n].entries.size() > MAX_ENTRIES)
+					split(n);
+			}
+		}
+
+		void collect (std::size_t n, std::vector <std::size_t> &ids) {
+			if (nodes[n].leaf)
+				ids.insert(ids.end(), nodes[n].entries.begin(), nodes[n].entries.end());
+			else
+				for (auto child : nodes[n].entries)
+					collect(child, ids);
+			nodes[n].entries.clear();
+			free_nodes.push_back(n);
+		}
+
+		// Walks up from a leaf that lost an entry: underfull nodes are cut off and their segments
+		// inserted again, the boxes of the rest shrink
+		void condense (std::size_t n) {
+			std::vector <std::size_t> orphans;
+			while (n != root) {
+				std::size_t parent = nodes[n].parent;
+				if (nodes[n].entries.size() < MIN_ENTRIES) {
+					std::vector <std::size_t> &siblings = nodes[parent].entries;
+					siblings.erase(std::find(siblings.begin(), siblings.end(), n));
+					collect(n, orphans);
+				} else
+					adopt(n);
+				n = parent;
+			}
+			adopt(root);
+			while (!nodes[root].leaf && nodes[root].entries.size() == 1) {
+				free_nodes.push_back(root);
+				root = nodes[root].entries[0];
+				nodes[root].parent = NONE;
+			}
+			if (nodes[root].entries.empty())
+				nodes[root].leaf = true;
+			for (auto id : orphans)
+				insert_entry(id);
+		}
+	public:
+		rtree () {
+			root = new_node(true);
+		}
+		explicit rtree (const std::vector <segment> &segments) {
+			std::vector <std::size_t> level;
+			for (auto &s : segments)
+				level.push_back(table.add(s));
+			leaf_of.resize(table.capacity());
+			bool leaf = true;
+			do {
+				level = pack(level, leaf);
+				leaf = false;
+			} while (level.size() > 1);
+			root = level.empty() ? new_node(true) : level[0];
+		}
+
+		std::size_t insert (const segment &s) {
+			std::size_t id = table.add(s);
+			if (leaf_of.size() < table.capacity())
+				leaf_of.resize(table.capacity());
+			insert_entry(id);
+			return id;
+		}
+		bool erase (std::size_t id) {
+			if (!table.contains(id))
+				return false;
+			std::vector <std::size_t> &entries = nodes[leaf_of[id]].entries;
+			entries.erase(std::find(entries.begin(), entries.end(), id));
+			table.remove(id);
+			condense(leaf_of[id]);
+			return true;
+		}
+		bool contains (std::size_t id) const {return table.contains(id);}
+		const segment &get (std::size_t id) const {return table.get(id);}
+		std::size_t size () const {return table.size();}
+
+		// Ids of the stored segments whose boxes overlap the window
+		std::vector <std::size_t> query (const box &window) const {
+			std::vector <std::size_t> found;
+			if (window.empty() || !nodes[root].bounds.overlaps(window))
+				return found;
+			std::vector <std::size_t> stack(1, root);
+			while (!stack.empty()) {
+				const node &n = nodes[stack.back()];
+				stack.pop_back();
+				for (auto entry : n.entries)
+					if (entry_bounds(n, entry).overlaps(window))
+						(n.leaf ? found : stack).push_back(entry);
+			}
+			return found;
+		}
+		// Ids of the stored segments that intersect s, in increasing order
+		std::vector <std::size_t> intersecting (const segment &s) const {
+			return table.filter(s, query(box(s)));
+		}
+	};
+}
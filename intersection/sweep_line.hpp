@@ -0,0 +1,316 @@
+#pragma once
+
+#include <map>
+#include <set>
+#include <unordered_set>
+#include <functional>
+#include <limits>
+#include <cmath>
+#include "intersection.hpp"
+
+namespace intersection {
+	// Exact sign of the turn a -> b -> c, whatever the default predicate: the sweep has to agree
+	// with itself on which side of a segment a point lies
+	inline int orientation (const pt &a, const pt &b, const pt &c) {
+		return exact_predicate::orientation(a, b, c);
+	}
+
+	struct crossing {
+		std::size_t first, second;	// indices of the segments, first < second
+		pt point;					// where they meet, the start of the common part for collinear ones
+	};
+
+	// Bentley-Ottmann sweep: reports the k intersecting pairs among n segments in O((n + k) log n).
+	// A vertical line moves left to right over the segment endpoints and the crossings found so far,
+	// keeping the segments it cuts ordered by height. Only neighbours in that order are tested, a
+	// crossing swaps them. One object runs one sweep
+	class sweep_line {
+		struct pt_less {
+			bool operator() (const pt &a, const pt &b) const {
+				return a.x() < b.x() || (a.x() == b.x() && a.y() < b.y());
+			}
+		};
+		struct event {
+			std::vector <std::size_t> starts, ends, crossings;
+		};
+		struct status_less {
+			const sweep_line *sweep;
+			bool operator() (std::size_t s, std::size_t t) const {return sweep->below(s, t);}
+		};
+		typedef std::set <std::size_t, status_less> status_t;
+
+		std::vector <pt> left, right;			// endpoints, left comes first in sweep order
+		std::map <pt, event, pt_less> queue;
+		status_t status;
+		std::vector <status_t::iterator> where;	// position of each segment under the line
+		std::vector <char> active, at_point;
+		std::size_t probe;						// stands for the current point in status searches
+		pt current;
+		std::function <bool (std::size_t, std::size_t)> accept;
+		std::unordered_set <unsigned long long> reported;
+		std::vector <crossing> found;
+
+		// Height at the line. Segments passing through the event point get its exact y, vertical
+		// ones are only under the line while the point is on them
+		double y_at (std::size_t s) const {
+			if (s == probe || at_point[s])
+				return current.y();
+			const pt &a = left[s], &b = right[s];
+			if (a.x() == b.x())
+				return current.y();
+			if (current.x() == a.x())
+				return a.y();
+			if (current.x() == b.x())
+				return b.y();
+			return a.y() + (current.x() - a.x()) * (b.y() - a.y()) / (b.x() - a.x());
+		}
+
+		// Ties at the line are broken by the order just right of it
+		double slope (std::size_t s) const {
+			if (s == probe)
+				return -std::numeric_limits<double>::infinity();
+			const pt &a = left[s], &b = right[s];
+			if (a.x() == b.x())
+				return std::numeric_limits<double>::infinity();
+			return (b.y() - a.y()) / (b.x() - a.x());
+		}
+
+		bool below (std::size_t s, std::size_t t) const {
+			if (s == t)
+				return false;
+			double ys = y_at(s), yt = y_at(t);
+			if (ys != yt)
+				return ys < yt;
+			double ks = slope(s), kt = slope(t);
+			if (ks != kt)
+				return ks < kt;
+			return s < t;
+		}
+
+		// Whether s goes through the event point. Crossings computed for different pairs of one
+		// bundle of lines round apart, so a segment missing the point by rounding still counts
+		bool passes (std::size_t s) const {
+			return orientation(left[s], right[s], current) == 0
+				|| std::fabs(y_at(s) - current.y()) <= 1e-9 * (1 + std::fabs(current.y()));
+		}
+
+		bool collinear (std::size_t s, std::size_t t) const {
+			return orientation(left[s], right[s], left[t]) == 0 && orientation(left[s], right[s], right[t]) == 0
+				&& orientation(left[t], right[t], left[s]) == 0 && orientation(left[t], right[t], right[s]) == 0;
+		}
+
+		bool cross (std::size_t s, std::size_t t) const {
+			if (collinear(s, t))
+				return !pt_less()(right[s], left[t]) && !pt_less()(right[t], left[s]);
+			return orientation(left[s], right[s], left[t]) * orientation(left[s], right[s], right[t]) <= 0
+				&& orientation(left[t], right[t], left[s]) * orientation(left[t], right[t], right[s]) <= 0;
+		}
+
+		// Meeting point of two crossing segments. Endpoints lying on the other segment are returned
+		// as they are, and the point is computed along a vertical segment to keep its x exact
+		pt meet (std::size_t s, std::size_t t) const {
+			if (collinear(s, t))
+				return pt_less()(left[s], left[t]) ? left[t] : left[s];
+			if (orientation(left[s], right[s], left[t]) == 0)
+				return left[t];
+			if (orientation(left[s], right[s], right[t]) == 0)
+				return right[t];
+			if (orientation(left[t], right[t], left[s]) == 0)
+				return left[s];
+			if (orientation(left[t], right[t], right[s]) == 0)
+				return right[s];
+			if (left[t].x() == right[t].x())
+				std::swap(s, t);
+			const pt &a = left[s], &b = right[s], &c = left[t], &d = right[t];
+			double det = (b.x() - a.x()) * (d.y() - c.y()) - (b.y() - a.y()) * (d.x() - c.x());
+			double r = ((c.x() - a.x()) * (d.y() - c.y()) - (c.y() - a.y()) * (d.x() - c.x())) / det;
+			if (r <= 0)
+				return a;
+			if (r >= 1)
+				return b;
+			return pt(a.x() + r * (b.x() - a.x()), a.y() + r * (b.y() - a.y()));
+		}
+
+		void report (std::size_t s, std::size_t t, const pt &point) {
+			if (s > t)
+				std::swap(s, t);
+			if (accept && !accept(s, t))
+				return;
+			if (reported.insert((unsigned long long)s * left.size() + t).second)
+				found.push_back(crossing{s, t, point});
+		}
+
+		// Tests two neighbours, lower under upper at the line. A crossing right of the line becomes an
+		// event that swaps them; one rounded to a point already passed swaps them at once
+		bool check (std::size_t lower, std::size_t upper) {
+			if (!cross(lower, upper))
+				return false;
+			pt point = meet(lower, upper);
+			report(lower, upper, point);
+			if (collinear(lower, upper))
+				return true;
+			bool ahead = pt_less()(current, point);
+			if (ahead || slope(lower) > slope(upper)) {
+				event &e = queue[ahead ? point : current];
+				e.crossings.push_back(lower);
+				e.crossings.push_back(upper);
+			}
+			return true;
+		}
+
+		void remove (std::size_t s) {
+			if (active[s]) {
+				status.erase(where[s]);
+				active[s] = 0;
+			}
+		}
+
+		void handle (event &e) {
+			std::vector <std::size_t> through(e.starts);
+			through.insert(through.end(), e.ends.begin(), e.ends.end());
+			through.insert(through.end(), e.crossings.begin(), e.crossings.end());
+			std::sort(through.begin(), through.end());
+			through.erase(std::unique(through.begin(), through.end()), through.end());
+			// Overlapping collinear segments lie next to each other and cross everything together
+			for (std::size_t i = 0, named = through.size(); i < named; ++i) {
+				if (!active[through[i]])
+					continue;
+				status_t::iterator at = where[through[i]];
+				for (status_t::iterator it = std::next(at); it != status.end() && collinear(*it, through[i]); ++it)
+					through.push_back(*it);
+				for (status_t::iterator it = at; it != status.begin() && collinear(*std::prev(it), through[i]); --it)
+					through.push_back(*std::prev(it));
+			}
+			std::sort(through.begin(), through.end());
+			through.erase(std::unique(through.begin(), through.end()), through.end());
+			for (std::size_t s : through)
+				remove(s);
+			// Segments the point lies on that no event named, such as one with an endpoint there
+			std::size_t named = through.size();
+			status_t::iterator up = status.lower_bound(probe);
+			for (status_t::iterator it = up; it != status.end() && passes(*it); ++it)
+				through.push_back(*it);
+			for (status_t::iterator it = up; it != status.begin() && passes(*std::prev(it)); --it)
+				through.push_back(*std::prev(it));
+			for (std::size_t i = named; i < through.size(); ++i)
+				remove(through[i]);
+			// Segments sharing the point meet there, endpoints shared by a polyline included
+			for (std::size_t i = 0; i < through.size(); ++i)
+				for (std::size_t j = i + 1; j < through.size(); ++j)
+					if (cross(through[i], through[j]))
+						report(through[i], through[j], current);
+
+			// Everything that goes on past the point comes back in the order right of it
+			std::vector <std::size_t> inserted;
+			for (std::size_t s : through)
+				if (!pt_less()(current, left[s]) && pt_less()(current, right[s]))
+					inserted.push_back(s);
+			if (inserted.empty()) {
+				up = status.lower_bound(probe);
+				if (up != status.begin() && up != status.end())
+					check(*std::prev(up), *up);
+				return;
+			}
+			for (std::size_t s : inserted)
+				at_point[s] = 1;
+			for (std::size_t s : inserted) {
+				where[s] = status.insert(s).first;
+				active[s] = 1;
+			}
+			std::size_t lowest = *std::min_element(inserted.begin(), inserted.end(), status_less{this});
+			std::size_t highest = *std::max_element(inserted.begin(), inserted.end(), status_less{this});
+			// Segments through the point that no event knew about end up among the inserted ones
+			for (status_t::iterator it = where[lowest]; it != std::next(where[highest]); ++it)
+				if (!at_point[*it])
+					for (std::size_t s : inserted)
+						below(*it, s) ? check(*it, s) : check(s, *it);
+			for (std::size_t s : inserted)
+				at_point[s] = 0;
+			// Neighbours outside that pass through the point meet all of the inserted ones, the
+			// first one that doesn't is an ordinary neighbour
+			for (status_t::iterator it = where[lowest]; it != status.begin(); ) {
+				--it;
+				if (!passes(*it)) {
+					check(*it, lowest);
+					break;
+				}
+				for (std::size_t s : inserted)
+					check(*it, s);
+			}
+			for (status_t::iterator it = std::next(where[highest]); it != status.end(); ++it) {
+				if (!passes(*it)) {
+					check(highest, *it);
+					break;
+				}
+				for (std::size_t s : inserted)
+					check(s, *it);
+			}
+			// A pair left crossed by rounding is swapped by another pass over this point, which
+			// orders everything put through it so far in one go
+			std::map <pt, event, pt_less>::iterator again = queue.find(current);
+			if (again != queue.end())
+				again->second.crossings.insert(again->second.crossings.end(), inserted.begin(), inserted.end());
+		}
+	public:
+		explicit sweep_line (const std::vector <segment> &segments)
+				: status(status_less{this}), probe(segments.size()), current(0.0, 0.0) {
+			left.reserve(segments.size());
+			right.reserve(segments.size());
+			for (std::size_t i = 0; i < segments.size(); ++i) {
+				pt a = segments[i].begin(), b = segments[i].end();
+				if (pt_less()(b, a))
+					std::swap(a, b);
+				left.push_back(a);
+				right.push_back(b);
+				queue[a].starts.push_back(i);
+				queue[b].ends.push_back(i);
+			}
+			where.resize(segments.size());
+			active.assign(segments.size(), 0);
+			at_point.assign(segments.size(), 0);
+		}
+		sweep_line (const sweep_line &) = delete;
+		sweep_line& operator = (const sweep_line &) = delete;
+
+		// Pairs for which accept(first, second) is false are skipped. With first_only the sweep
+		// stops at the first reported pair, which answers "is there any intersection" early
+		std::vector <crossing> run (bool first_only = false,
+				std::function <bool (std::size_t, std::size_t)> accept = nullptr) {
+			this->accept = std::move(accept);
+			while (!queue.empty() && !(first_only && !found.empty())) {
+				std::map <pt, event, pt_less>::iterator next = queue.begin();
+				current = next->first;
+				event e = std::move(next->second);
+				queue.erase(next);
+				handle(e);
+			}
+			return std::move(found);
+		}
+	};
+
+	inline std::vector <crossing> find_intersections (const std::vector <segment> &segments) {
+		sweep_line sweep(segments);
+		return sweep.run();
+	}
+
+	inline bool any_intersection (const std::vector <segment> &segments) {
+		sweep_line sweep(segments);
+		return !sweep.run(true).empty();
+	}
+
+	// Crossings of a polyline with itself. Neighbouring segments always meet at their common
+	// vertex, so their pairs are left out
+	inline std::vector <crossing> self_intersections (const random_sequence &x) {
+		sweep_line sweep(x.get_segments());
+		return sweep.run(false, [](std::size_t i, std::size_t j) {return j - i != 1;});
+	}
+
+	// Whether two polylines cross, the sweep stops at the first crossing
+	inline bool intersect (const random_sequence &a, const random_sequence &b) {
+		std::vector <segment> all(a.get_segments());
+		all.insert(all.end(), b.get_segments().begin(), b.get_segments().end());
+		std::size_t n = a.get_segments().size();
+		sweep_line sweep(all);
+		return !sweep.run(true, [n](std::size_t i, std::size_t j) {return i < n && j >= n;}).empty();
+	}
+}